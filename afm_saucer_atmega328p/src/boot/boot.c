@@ -0,0 +1,405 @@
+/***********************************************************************
+ *    _   _   _             _     __                                           
+ *   /_\ | |_| |_ __ _  ___| | __/ _|_ __ ___  _ __ ___   /\/\   __ _ _ __ ___ 
+ *  //_\\| __| __/ _` |/ __| |/ / |_| '__/ _ \| '_ ` _ \ /    \ / _` | '__/ __|
+ * /  _  \ |_| || (_| | (__|   <|  _| | | (_) | | | | | / /\/\ \ (_| | |  \__ \
+ * \_/ \_/\__|\__\__,_|\___|_|\_\_| |_|  \___/|_| |_| |_\/    \/\__,_|_|  |___/
+ *
+ *                              ____ ____ ___ 
+ *                              |--< |__, |==]
+ *
+ *                      ____ ____ _  _ ____ ____ ____
+ *                      ==== |--| |__| |___ |=== |--<
+ *
+ *  Copyright (c) 2022 bitfield labs
+ * 
+ ***********************************************************************
+ *  This file is part of the Attack from Mars! RGB saucer project:
+ *  https://github.com/bitfieldlabs/afm_saucer
+ *
+ *  The AfM RGB saucer is free software: you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public License as
+ *  published by the Free Software Foundation, either version 3 of the
+ *  License, or (at your option) any later version.
+ *
+ *  AfM RGB saucer is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with afterglow.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ ***********************************************************************/
+
+#include <avr/boot.h>
+#include <avr/pgmspace.h>
+#include <avr/wdt.h>
+#include <util/crc16.h>
+#include <util/delay.h>
+#include <stddef.h>
+#include "boot.h"
+
+
+//------------------------------------------------------------------------------
+// definitions
+
+#define BOOT_UBRR ((F_CPU / (8UL * BOOT_BAUD)) - 1)   // double speed mode
+#define PAGE_MASK (SPM_PAGESIZE - 1)
+
+typedef struct INFLATE_s
+{
+    uint16_t length;    // image length [bytes]
+    uint16_t crc;       // image CRC from the header
+    uint16_t out;       // next byte address to write
+    uint8_t flags;      // item flags, the next item in bit 0
+    uint8_t items;      // items left of the flag byte
+    bool match;         // first byte of a back reference received
+    uint8_t lo;         // first byte of the back reference
+    uint8_t block;      // index of the next data block
+    bool valid;         // header received
+} INFLATE_t;
+
+
+//------------------------------------------------------------------------------
+// global variables
+
+static INFLATE_t sInf;                         // decompressor state
+static uint8_t sPage[SPM_PAGESIZE];            // flash page being decompressed
+static uint8_t sBlock[256];                    // received data block
+
+
+//------------------------------------------------------------------------------
+// declarations
+
+static void startApp() __attribute__ ((noreturn));
+
+
+//------------------------------------------------------------------------------
+static void uartPut(uint8_t v)
+{
+    loop_until_bit_is_set(UCSR0A, UDRE0);
+    UDR0 = v;
+}
+
+//------------------------------------------------------------------------------
+static bool uartReady()
+{
+    wdt_reset();
+    return (UCSR0A & (1 << RXC0));
+}
+
+//------------------------------------------------------------------------------
+static uint8_t uartGet()
+{
+    while (!uartReady())
+    {
+        // wait for the host
+    }
+    return UDR0;
+}
+
+//------------------------------------------------------------------------------
+static uint16_t uartGet16()
+{
+    uint8_t lo = uartGet();
+    return ((uint16_t)uartGet() << 8) | lo;
+}
+
+//------------------------------------------------------------------------------
+static void writePage(uint16_t addr)
+{
+    // The boot section keeps running while the application section is
+    // programmed, the watchdog gets fed meanwhile.
+    boot_page_erase(addr);
+    while (boot_spm_busy())
+    {
+        wdt_reset();
+    }
+    for (uint8_t i=0; i<SPM_PAGESIZE; i+=2)
+    {
+        boot_page_fill(addr + i, sPage[i] | ((uint16_t)sPage[i + 1] << 8));
+    }
+    boot_page_write(addr);
+    while (boot_spm_busy())
+    {
+        wdt_reset();
+    }
+    boot_rww_enable();
+}
+
+//------------------------------------------------------------------------------
+static void writeRecord(uint16_t magic)
+{
+    for (uint8_t i=0; i<SPM_PAGESIZE; i++)
+    {
+        sPage[i] = 0xff;
+    }
+    BOOT_RECORD_t *r = (BOOT_RECORD_t*)sPage;
+    r->magic = magic;
+    r->length = sInf.length;
+    r->crc = sInf.crc;
+    writePage(BOOT_RECORD);
+}
+
+//------------------------------------------------------------------------------
+static uint16_t flashCrc(uint16_t length)
+{
+    uint16_t crc = 0;
+    for (uint16_t a=0; a<length; a++)
+    {
+        crc = _crc_xmodem_update(crc, pgm_read_byte(a));
+        if (!(a & PAGE_MASK))
+        {
+            wdt_reset();
+        }
+    }
+    return crc;
+}
+
+//------------------------------------------------------------------------------
+static bool appValid(bool verify)
+{
+    // The image CRC takes about 57ms over a full flash. It is checked after
+    // power on and external resets, warm starts trust the record written
+    // after the upload's own check.
+    uint16_t magic = pgm_read_word(BOOT_RECORD + offsetof(BOOT_RECORD_t, magic));
+    if (magic == 0xffff)
+    {
+        // no record, the image was flashed by ISP
+        return (pgm_read_word(0) != 0xffff);
+    }
+    uint16_t length = pgm_read_word(BOOT_RECORD + offsetof(BOOT_RECORD_t, length));
+    if ((magic != BOOT_MAGIC) || (length > BOOT_APP_MAX))
+    {
+        return false;
+    }
+    return (!verify || (flashCrc(length) == pgm_read_word(BOOT_RECORD + offsetof(BOOT_RECORD_t, crc))));
+}
+
+//------------------------------------------------------------------------------
+static void startApp()
+{
+    // leave the USART as found after reset, MCUSR is kept for the application
+    loop_until_bit_is_set(UCSR0A, UDRE0);
+    UCSR0B = 0;
+    UCSR0A = 0;
+    UBRR0 = 0;
+    asm volatile ("jmp 0");
+    __builtin_unreachable();
+}
+
+//------------------------------------------------------------------------------
+static bool putByte(uint8_t v)
+{
+    if (sInf.out >= sInf.length)
+    {
+        return false;
+    }
+    sPage[sInf.out & PAGE_MASK] = v;
+    sInf.out++;
+    if (!(sInf.out & PAGE_MASK))
+    {
+        writePage(sInf.out - SPM_PAGESIZE);
+    }
+    return true;
+}
+
+//------------------------------------------------------------------------------
+static bool inflate(uint8_t v)
+{
+    if (sInf.match)
+    {
+        // back reference, older pages are read back from the flash
+        uint16_t dist = ((((uint16_t)v >> 4) << 8) | sInf.lo) + 1;
+        uint8_t len = (v & 0x0f) + BOOT_LZ_MIN;
+        if (dist > sInf.out)
+        {
+            return false;
+        }
+        uint16_t src = (sInf.out - dist);
+        for (; len; len--, src++)
+        {
+            uint8_t b = (src >= (sInf.out & ~PAGE_MASK)) ? sPage[src & PAGE_MASK] : pgm_read_byte(src);
+            if (!putByte(b))
+            {
+                return false;
+            }
+        }
+        sInf.match = false;
+    }
+    else if (!sInf.items)
+    {
+        sInf.flags = v;
+        sInf.items = 8;
+        return true;
+    }
+    else if (sInf.flags & 0x01)
+    {
+        if (!putByte(v))
+        {
+            return false;
+        }
+    }
+    else
+    {
+        sInf.lo = v;
+        sInf.match = true;
+        return true;
+    }
+    sInf.flags >>= 1;
+    sInf.items--;
+    return true;
+}
+
+//------------------------------------------------------------------------------
+static uint8_t header()
+{
+    uint16_t length = uartGet16();
+    uint16_t crc = uartGet16();
+    if (length > BOOT_APP_MAX)
+    {
+        return BOOT_NAK;
+    }
+
+    // An interrupted upload leaves an incomplete record, which keeps the
+    // bootloader from starting the partial image.
+    sInf.length = length;
+    sInf.crc = crc;
+    writeRecord(0);
+    sInf.out = 0;
+    sInf.items = 0;
+    sInf.match = false;
+    sInf.block = 0;
+    sInf.valid = true;
+    return BOOT_ACK;
+}
+
+//------------------------------------------------------------------------------
+static uint8_t data(uint8_t *block)
+{
+    *block = uartGet();
+    uint8_t n = uartGet();
+    uint16_t crc = _crc_xmodem_update(0, *block);
+    for (uint8_t i=0; i<n; i++)
+    {
+        sBlock[i] = uartGet();
+        crc = _crc_xmodem_update(crc, sBlock[i]);
+    }
+    if ((uartGet16() != crc) || !sInf.valid)
+    {
+        return BOOT_NAK;
+    }
+    if (*block == (uint8_t)(sInf.block - 1))
+    {
+        // the host missed the acknowledge and sent the block again
+        return BOOT_ACK;
+    }
+    if (*block != sInf.block)
+    {
+        return BOOT_NAK;
+    }
+    for (uint8_t i=0; i<n; i++)
+    {
+        if (!inflate(sBlock[i]))
+        {
+            // broken stream, a new header is needed
+            sInf.valid = false;
+            return BOOT_NAK;
+        }
+    }
+    sInf.block++;
+    return BOOT_ACK;
+}
+
+//------------------------------------------------------------------------------
+static uint8_t finish()
+{
+    if (!sInf.valid || (sInf.out != sInf.length))
+    {
+        return BOOT_NAK;
+    }
+    sInf.valid = false;
+    if (sInf.out & PAGE_MASK)
+    {
+        // pad the last page
+        for (uint8_t i=(sInf.out & PAGE_MASK); i<SPM_PAGESIZE; i++)
+        {
+            sPage[i] = 0xff;
+        }
+        writePage(sInf.out & ~PAGE_MASK);
+    }
+    if (flashCrc(sInf.length) != sInf.crc)
+    {
+        return BOOT_BAD_CRC;
+    }
+    writeRecord(BOOT_MAGIC);
+    return BOOT_ACK;
+}
+
+//------------------------------------------------------------------------------
+static bool waitSync(bool timeout)
+{
+    // look for an upload request, forever without a valid application
+    for (uint16_t t=0; !timeout || (t < (BOOT_WAIT_MS * 10)); t++)
+    {
+        if (uartReady() && (UDR0 == BOOT_SYNC))
+        {
+            return true;
+        }
+        _delay_us(100);
+    }
+    return false;
+}
+
+//------------------------------------------------------------------------------
+int main()
+{
+    // A watchdog reset leaves the watchdog running, it is fed instead of
+    // stopped since that would clear the reset flags of the application.
+    wdt_reset();
+    // same test as the application: a power on sets BORF as well
+    uint8_t flags = MCUSR;
+    bool warm = !(flags & (1 << PORF)) && (flags & ((1 << WDRF) | (1 << BORF)));
+    bool valid = appValid(!warm);
+    if (valid && warm)
+    {
+        // warm start, no delay
+        startApp();
+    }
+
+    UBRR0 = BOOT_UBRR;
+    UCSR0A = (1 << U2X0);
+    UCSR0B = (1 << RXEN0) | (1 << TXEN0);
+    UCSR0C = (1 << UCSZ01) | (1 << UCSZ00); // 8N1
+    if (!waitSync(valid))
+    {
+        startApp();
+    }
+    uartPut(BOOT_READY);
+
+    bool done = false;
+    while (!done)
+    {
+        uint8_t reply;
+        uint8_t block;
+        switch (uartGet())
+        {
+            case BOOT_SYNC: reply = BOOT_READY; break;
+            case BOOT_HEADER: reply = header(); break;
+            case BOOT_DATA:
+                reply = data(&block);
+                if (reply == BOOT_ACK)
+                {
+                    // the index tells the host which block was taken
+                    uartPut(BOOT_ACK);
+                    reply = block;
+                }
+                break;
+            case BOOT_FINISH: reply = finish(); done = (reply == BOOT_ACK); break;
+            default: continue;      // line noise
+        }
+        uartPut(reply);
+    }
+    startApp();
+}
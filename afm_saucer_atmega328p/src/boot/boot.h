@@ -0,0 +1,82 @@
+/***********************************************************************
+ *    _   _   _             _     __                                           
+ *   /_\ | |_| |_ __ _  ___| | __/ _|_ __ ___  _ __ ___   /\/\   __ _ _ __ ___ 
+ *  //_\\| __| __/ _` |/ __| |/ / |_| '__/ _ \| '_ ` _ \ /    \ / _` | '__/ __|
+ * /  _  \ |_| || (_| | (__|   <|  _| | | (_) | | | | | / /\/\ \ (_| | |  \__ \
+ * \_/ \_/\__|\__\__,_|\___|_|\_\_| |_|  \___/|_| |_| |_\/    \/\__,_|_|  |___/
+ *
+ *                              ____ ____ ___ 
+ *                              |--< |__, |==]
+ *
+ *                      ____ ____ _  _ ____ ____ ____
+ *                      ==== |--| |__| |___ |=== |--<
+ *
+ *  Copyright (c) 2022 bitfield labs
+ * 
+ ***********************************************************************
+ *  This file is part of the Attack from Mars! RGB saucer project:
+ *  https://github.com/bitfieldlabs/afm_saucer
+ *
+ *  The AfM RGB saucer is free software: you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public License as
+ *  published by the Free Software Foundation, either version 3 of the
+ *  License, or (at your option) any later version.
+ *
+ *  AfM RGB saucer is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with afterglow.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ ***********************************************************************/
+
+// Serial bootloader, lives in the 2KB boot section selected by the fuses
+// (hfuse 0xDA: BOOTSZ=01, BOOTRST programmed) and is flashed once by ISP.
+// Images are uploaded with tools/boot_upload.py, see tools/README.md.
+//
+// Protocol, all host commands are answered with a single byte:
+//
+//   BOOT_SYNC                                  -> BOOT_READY
+//   BOOT_HEADER len[2] crc[2]                  -> BOOT_ACK, BOOT_NAK if too large
+//   BOOT_DATA ix n data[n] crc[2]              -> BOOT_ACK ix, BOOT_NAK if corrupted
+//   BOOT_FINISH                                -> BOOT_ACK and start, BOOT_BAD_CRC
+//
+// Words are little endian, CRCs are CRC-16/XMODEM, the data block CRC covers
+// ix and the data. The data blocks carry the LZSS compressed image and are
+// decompressed into flash pages as they arrive. ix counts the blocks from 0
+// after the header and wraps at 256. A corrupted block has no effect and may
+// be sent again. A block sent again because its acknowledge was lost is
+// acknowledged once more but not decompressed twice.
+
+#include <avr/io.h>
+#include <stdbool.h>
+
+#define BOOT_BAUD 115200UL      // baud rate on the PD0/PD1 pins, like the UART builds
+#define BOOT_START 0x7800       // boot section start [byte address]
+#define BOOT_RECORD (BOOT_START - SPM_PAGESIZE)     // image record, the last application page [byte address]
+#define BOOT_APP_MAX BOOT_RECORD                    // maximum application image size [bytes]
+#define BOOT_MAGIC 0xb007       // record magic of a complete image
+#define BOOT_WAIT_MS 500        // upload request window after power on and external resets [ms]
+
+// LZSS format: a flag byte precedes every 8 items, set bits are literal
+// bytes, cleared bits back references of two bytes with the distance - 1
+// in the lower 12 bits and the length - BOOT_LZ_MIN in the upper 4 bits.
+#define BOOT_LZ_MIN 3           // shortest back reference [bytes]
+
+#define BOOT_SYNC 'U'           // upload request, repeated by the host until answered
+#define BOOT_READY 'B'          // bootloader waiting for commands
+#define BOOT_HEADER 'H'         // image length and CRC
+#define BOOT_DATA 'D'           // compressed data block
+#define BOOT_FINISH 'F'         // end of the image
+#define BOOT_ACK 'K'            // command done
+#define BOOT_NAK 'E'            // command rejected
+#define BOOT_BAD_CRC 'C'        // image CRC mismatch, the application is not started
+
+typedef struct BOOT_RECORD_s
+{
+    uint16_t magic;     // BOOT_MAGIC, 0xffff if blank (image flashed by ISP), else incomplete
+    uint16_t length;    // image length [bytes]
+    uint16_t crc;       // image CRC
+} BOOT_RECORD_t;
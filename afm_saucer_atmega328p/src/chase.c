@@ -0,0 +1,169 @@
+/***********************************************************************
+ *    _   _   _             _     __                                           
+ *   /_\ | |_| |_ __ _  ___| | __/ _|_ __ ___  _ __ ___   /\/\   __ _ _ __ ___ 
+ *  //_\\| __| __/ _` |/ __| |/ / |_| '__/ _ \| '_ ` _ \ /    \ / _` | '__/ __|
+ * /  _  \ |_| || (_| | (__|   <|  _| | | (_) | | | | | / /\/\ \ (_| | |  \__ \
+ * \_/ \_/\__|\__\__,_|\___|_|\_\_| |_|  \___/|_| |_| |_\/    \/\__,_|_|  |___/
+ *
+ *                              ____ ____ ___ 
+ *                              |--< |__, |==]
+ *
+ *                      ____ ____ _  _ ____ ____ ____
+ *                      ==== |--| |__| |___ |=== |--<
+ *
+ *  Copyright (c) 2022 bitfield labs
+ * 
+ ***********************************************************************
+ *  This file is part of the Attack from Mars! RGB saucer project:
+ *  https://github.com/bitfieldlabs/afm_saucer
+ *
+ *  The AfM RGB saucer is free software: you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public License as
+ *  published by the Free Software Foundation, either version 3 of the
+ *  License, or (at your option) any later version.
+ *
+ *  AfM RGB saucer is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with afterglow.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ ***********************************************************************/
+
+#include <stdbool.h>
+#include "chase.h"
+
+#ifdef FEATURE_CHASE
+
+
+//------------------------------------------------------------------------------
+// definitions
+
+#define CHASE_MAX_STEP 2        // largest lamp rotation between two lamp states [lamps]
+#define CHASE_PERIOD_TOL 1      // accepted deviation from the predicted period [frames]
+#define CHASE_LOCK_HITS 2       // consecutive hits before leading edges are drawn
+
+
+//------------------------------------------------------------------------------
+// global variables
+
+static uint16_t sChaseState = 0;        // last lamp state
+static int8_t sChaseStep = 0;           // rotation predicted for the next state, 0 for none
+static uint8_t sChasePeriod = 0;        // frames between the last two lamp states
+static uint8_t sChaseAge = 0;           // frames since the last lamp state change
+static uint8_t sChaseHits = 0;          // consecutive correct predictions
+static uint32_t sChaseHitCnt = 0;       // total correct predictions
+static uint32_t sChaseMissCnt = 0;      // total wrong or overdue predictions
+
+
+//------------------------------------------------------------------------------
+uint16_t rotate(uint16_t state, int8_t n)
+{
+    // rotate the lamp state by n positions, positive towards higher lamps
+    uint8_t s = (n & 0x0f);
+    return s ? (uint16_t)((state << s) | (state >> (16 - s))) : state;
+}
+
+//------------------------------------------------------------------------------
+void chaseReset()
+{
+    sChaseStep = 0;
+    sChaseHits = 0;
+    sChaseAge = 0;
+}
+
+//------------------------------------------------------------------------------
+void chaseMiss()
+{
+    // fall back to purely reactive rendering until locked again
+    sChaseMissCnt++;
+    sChaseHits = 0;
+}
+
+//------------------------------------------------------------------------------
+void chaseUpdate(uint16_t state)
+{
+    // Called once per frame with the current lamp state. A chase is a lamp
+    // state which rotates by a fixed step at a fixed period, so every change
+    // predicts the next one.
+    if (sChaseAge < 255)
+    {
+        sChaseAge++;
+    }
+    if (state == sChaseState)
+    {
+        if (sChaseStep && (sChaseAge > (sChasePeriod + CHASE_PERIOD_TOL)))
+        {
+            // overdue, the chase stopped
+            chaseMiss();
+            sChaseStep = 0;
+        }
+        return;
+    }
+
+    // verify the prediction
+    if (sChaseStep)
+    {
+        if ((state == rotate(sChaseState, sChaseStep)) &&
+            ((sChaseAge + CHASE_PERIOD_TOL) >= sChasePeriod))
+        {
+            sChaseHitCnt++;
+            if (sChaseHits < 255)
+            {
+                sChaseHits++;
+            }
+        }
+        else
+        {
+            chaseMiss();
+        }
+    }
+
+    // estimate the step and period of the next change from this one
+    sChaseStep = 0;
+    for (int8_t n=1; n<=CHASE_MAX_STEP; n++)
+    {
+        if (state == rotate(sChaseState, n))
+        {
+            sChaseStep = n;
+            break;
+        }
+        if (state == rotate(sChaseState, -n))
+        {
+            sChaseStep = -n;
+            break;
+        }
+    }
+    sChasePeriod = sChaseAge;
+    sChaseAge = 0;
+    sChaseState = state;
+}
+
+//------------------------------------------------------------------------------
+uint8_t chaseLead(uint8_t pos)
+{
+    // brightness of the leading edge at LED pos, ramping up towards the
+    // predicted next lamp state, 0 while not locked
+    if ((sChaseHits < CHASE_LOCK_HITS) || (sChasePeriod == 0))
+    {
+        return 0;
+    }
+    uint16_t next = (rotate(sChaseState, sChaseStep) & ~sChaseState);
+    if (!((next >> pos) & 0x01))
+    {
+        return 0;
+    }
+    uint8_t age = (sChaseAge < sChasePeriod) ? sChaseAge : sChasePeriod;
+    return (uint8_t)(((uint16_t)age * 255) / sChasePeriod);
+}
+
+//------------------------------------------------------------------------------
+void getChaseStats(uint32_t *hits, uint32_t *misses)
+{
+    *hits = sChaseHitCnt;
+    *misses = sChaseMissCnt;
+}
+
+#endif
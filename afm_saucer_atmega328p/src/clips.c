@@ -0,0 +1,153 @@
+/***********************************************************************
+ *    _   _   _             _     __                                           
+ *   /_\ | |_| |_ __ _  ___| | __/ _|_ __ ___  _ __ ___   /\/\   __ _ _ __ ___ 
+ *  //_\\| __| __/ _` |/ __| |/ / |_| '__/ _ \| '_ ` _ \ /    \ / _` | '__/ __|
+ * /  _  \ |_| || (_| | (__|   <|  _| | | (_) | | | | | / /\/\ \ (_| | |  \__ \
+ * \_/ \_/\__|\__\__,_|\___|_|\_\_| |_|  \___/|_| |_| |_\/    \/\__,_|_|  |___/
+ *
+ *                              ____ ____ ___ 
+ *                              |--< |__, |==]
+ *
+ *                      ____ ____ _  _ ____ ____ ____
+ *                      ==== |--| |__| |___ |=== |--<
+ *
+ *  Copyright (c) 2022 bitfield labs
+ * 
+ ***********************************************************************
+ *  This file is part of the Attack from Mars! RGB saucer project:
+ *  https://github.com/bitfieldlabs/afm_saucer
+ *
+ *  The AfM RGB saucer is free software: you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public License as
+ *  published by the Free Software Foundation, either version 3 of the
+ *  License, or (at your option) any later version.
+ *
+ *  AfM RGB saucer is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with afterglow.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ ***********************************************************************/
+
+#include <string.h>
+#include <avr/pgmspace.h>
+#include "clips.h"
+#include "modes.h"
+
+#ifdef FEATURE_CLIPS
+
+
+//------------------------------------------------------------------------------
+// global variables
+
+static const CLIP_t *sClip = NULL;          // clip playing, NULL if none
+static const uint8_t *sClipPos = NULL;      // next frame in the clip stream
+static uint8_t sClipCount = 0;              // frames until the next clip frame
+static uint8_t sClipFrame[NUM_LEDS][3];     // current clip frame, delta decoding base
+
+
+//------------------------------------------------------------------------------
+void clipRewind()
+{
+    // the first frame is encoded against black
+    memset(sClipFrame, 0, sizeof(sClipFrame));
+    sClipPos = pgm_read_ptr(&sClip->data);
+    sClipCount = 0;
+}
+
+//------------------------------------------------------------------------------
+void clipStart(const CLIP_t *clip)
+{
+    sClip = clip;
+    if (sClip)
+    {
+        clipRewind();
+    }
+}
+
+//------------------------------------------------------------------------------
+bool clipActive()
+{
+    return (sClip != NULL);
+}
+
+//------------------------------------------------------------------------------
+void decodeFrame()
+{
+    // Apply the runs of one frame to the previous one. Unchanged pixels are
+    // skipped as a whole, so the cost depends on the changed pixels only.
+    const uint8_t *p = sClipPos;
+    uint8_t op = pgm_read_byte(p);
+    if (op == CLIP_END_CLIP)
+    {
+        if (!pgm_read_byte(&sClip->loop))
+        {
+            // hold the last frame
+            return;
+        }
+        clipRewind();
+        p = sClipPos;
+    }
+
+    uint8_t pos = 0;
+    while ((op = pgm_read_byte(p++)) != CLIP_END_FRAME)
+    {
+        uint8_t n = (op & CLIP_RUN_MASK);
+        if ((pos + n) > NUM_LEDS)
+        {
+            // broken clip, stop it rather than write past the frame
+            sClip = NULL;
+            return;
+        }
+        switch (op & CLIP_OP_MASK)
+        {
+            case CLIP_OP_LITERAL:
+                memcpy_P(sClipFrame[pos], p, (n * 3));
+                p += (n * 3);
+                pos += n;
+                break;
+            case CLIP_OP_FILL:
+                for (; n; n--, pos++)
+                {
+                    memcpy_P(sClipFrame[pos], p, 3);
+                }
+                p += 3;
+                break;
+            case CLIP_OP_SKIP:
+                pos += n;
+                break;
+            default:
+                break;
+        }
+    }
+    sClipPos = p;
+}
+
+//------------------------------------------------------------------------------
+void clipAdvance()
+{
+    if (!sClip)
+    {
+        return;
+    }
+    if (sClipCount == 0)
+    {
+        decodeFrame();
+        sClipCount = pgm_read_byte(&sClip->frameDelay);
+    }
+    sClipCount--;
+}
+
+//------------------------------------------------------------------------------
+void clipPixel(uint8_t pos, uint8_t *r, uint8_t *g, uint8_t *b)
+{
+    const uint8_t *c = sClipFrame[pos];
+    *r = c[0];
+    *g = c[1];
+    *b = c[2];
+}
+
+#endif
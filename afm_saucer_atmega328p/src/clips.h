@@ -0,0 +1,67 @@
+/***********************************************************************
+ *    _   _   _             _     __                                           
+ *   /_\ | |_| |_ __ _  ___| | __/ _|_ __ ___  _ __ ___   /\/\   __ _ _ __ ___ 
+ *  //_\\| __| __/ _` |/ __| |/ / |_| '__/ _ \| '_ ` _ \ /    \ / _` | '__/ __|
+ * /  _  \ |_| || (_| | (__|   <|  _| | | (_) | | | | | / /\/\ \ (_| | |  \__ \
+ * \_/ \_/\__|\__\__,_|\___|_|\_\_| |_|  \___/|_| |_| |_\/    \/\__,_|_|  |___/
+ *
+ *                              ____ ____ ___ 
+ *                              |--< |__, |==]
+ *
+ *                      ____ ____ _  _ ____ ____ ____
+ *                      ==== |--| |__| |___ |=== |--<
+ *
+ *  Copyright (c) 2022 bitfield labs
+ * 
+ ***********************************************************************
+ *  This file is part of the Attack from Mars! RGB saucer project:
+ *  https://github.com/bitfieldlabs/afm_saucer
+ *
+ *  The AfM RGB saucer is free software: you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public License as
+ *  published by the Free Software Foundation, either version 3 of the
+ *  License, or (at your option) any later version.
+ *
+ *  AfM RGB saucer is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with afterglow.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ ***********************************************************************/
+
+#include <avr/io.h>
+#include <stdbool.h>
+#include "options.h"
+
+// Clip stream opcodes, the lower 6 bits hold the run length [pixels]
+#define CLIP_OP_LITERAL 0x00    // run of pixels, each followed by r, g, b
+#define CLIP_OP_FILL 0x40       // run of pixels in the one colour r, g, b following
+#define CLIP_OP_SKIP 0x80       // run of pixels unchanged from the previous frame
+#define CLIP_OP_MASK 0xc0
+#define CLIP_RUN_MASK 0x3f
+#define CLIP_END_FRAME 0x00     // literal run of 0 pixels ends a frame
+#define CLIP_END_CLIP 0xc0      // end of the clip, in place of a frame
+
+// precomputed animation in PROGMEM, generated by tools/clip_compress.py
+typedef struct CLIP_s
+{
+    const uint8_t *data;    // compressed frames in PROGMEM
+    uint8_t frameDelay;     // clip frame duration, at least 1 [frames]
+    bool loop;              // restart at the end, otherwise hold the last frame
+} CLIP_t;
+
+#ifdef FEATURE_CLIPS
+void clipStart(const CLIP_t *clip);
+bool clipActive();
+void clipAdvance();
+void clipPixel(uint8_t pos, uint8_t *r, uint8_t *g, uint8_t *b);
+#else
+// no clips, the patterns keep their computed backgrounds, see options.h
+static inline void clipStart(const CLIP_t *clip) {}
+static inline bool clipActive() { return false; }
+static inline void clipAdvance() {}
+static inline void clipPixel(uint8_t pos, uint8_t *r, uint8_t *g, uint8_t *b) {}
+#endif
@@ -0,0 +1,167 @@
+/***********************************************************************
+ *    _   _   _             _     __                                           
+ *   /_\ | |_| |_ __ _  ___| | __/ _|_ __ ___  _ __ ___   /\/\   __ _ _ __ ___ 
+ *  //_\\| __| __/ _` |/ __| |/ / |_| '__/ _ \| '_ ` _ \ /    \ / _` | '__/ __|
+ * /  _  \ |_| || (_| | (__|   <|  _| | | (_) | | | | | / /\/\ \ (_| | |  \__ \
+ * \_/ \_/\__|\__\__,_|\___|_|\_\_| |_|  \___/|_| |_| |_\/    \/\__,_|_|  |___/
+ *
+ *                              ____ ____ ___ 
+ *                              |--< |__, |==]
+ *
+ *                      ____ ____ _  _ ____ ____ ____
+ *                      ==== |--| |__| |___ |=== |--<
+ *
+ *  Copyright (c) 2022 bitfield labs
+ * 
+ ***********************************************************************
+ *  This file is part of the Attack from Mars! RGB saucer project:
+ *  https://github.com/bitfieldlabs/afm_saucer
+ *
+ *  The AfM RGB saucer is free software: you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public License as
+ *  published by the Free Software Foundation, either version 3 of the
+ *  License, or (at your option) any later version.
+ *
+ *  AfM RGB saucer is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with afterglow.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ ***********************************************************************/
+
+#include "debug.h"
+#include "uart.h"
+#include "stack.h"
+#include "events.h"
+#include "timer.h"
+#include "modes.h"
+#include "chase.h"
+#include "governor.h"
+#ifdef FRAME_MIRROR
+#include "mirror.h"
+#endif
+
+
+//------------------------------------------------------------------------------
+// global variables
+
+static uint16_t sRenderTicksMax = 0;           // longest frame update
+static uint16_t sDitherTicksMax = 0;           // longest dithering refresh
+static uint32_t sDitherFrames = 0;             // frames with dithering active
+static bool sLampPending = false;              // a lamp frame waits to be shown
+static uint16_t sLampTime = 0;                 // arrival of the oldest lamp frame not shown yet [ticks]
+static uint16_t sLatencyMax = 0;               // longest lamp in to light out latency [ticks]
+static uint32_t sLatencySum = 0;               // sum of all latencies [ticks]
+static uint32_t sLatencyNum = 0;               // number of latencies summed up
+static uint32_t sPassFrames = 0;               // lamp frames shown right away by the passthrough
+
+
+//------------------------------------------------------------------------------
+void debugRenderTime(uint16_t ticks)
+{
+    if (ticks > sRenderTicksMax)
+    {
+        sRenderTicksMax = ticks;
+    }
+}
+
+//------------------------------------------------------------------------------
+void debugDitherTime(uint16_t ticks, bool dither)
+{
+    if (dither)
+    {
+        sDitherFrames++;
+        if (ticks > sDitherTicksMax)
+        {
+            sDitherTicksMax = ticks;
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+void debugLampIn(uint16_t time)
+{
+    if (!sLampPending)
+    {
+        sLampTime = time;
+        sLampPending = true;
+    }
+}
+
+//------------------------------------------------------------------------------
+void debugLightOut(bool passthrough)
+{
+    // called after the LED string has been sent
+    if (passthrough)
+    {
+        sPassFrames++;
+    }
+    if (sLampPending)
+    {
+        uint16_t l = (timerTicks() - sLampTime);
+        if (l > sLatencyMax)
+        {
+            sLatencyMax = l;
+        }
+        sLatencySum += l;
+        sLatencyNum++;
+        sLampPending = false;
+    }
+}
+
+//------------------------------------------------------------------------------
+static void printStat(const char *name, uint32_t v)
+{
+    uartPuts(name);
+    uartPutc(' ');
+    uartPutDec(v);
+    uartPutc('\n');
+}
+
+//------------------------------------------------------------------------------
+void debugStats()
+{
+    // one "<name> <value>" line per counter
+    uartPuts("STATS\n");
+    printStat("stack_max", stackHighWater());
+    printStat("stack_unused", stackUnused());
+    printStat("events_lost", svEventsLost);
+    printStat("render_max_us", (uint32_t)sRenderTicksMax * TIMER_TICK_US);
+    printStat("dither_max_us", (uint32_t)sDitherTicksMax * TIMER_TICK_US);
+    printStat("dither_frames", sDitherFrames);
+    uint16_t peak, avg;
+    uint32_t limited;
+    getPowerStats(&peak, &avg, &limited);
+    printStat("power_peak_ma", peak);
+    printStat("power_avg_ma", avg);
+    printStat("power_limited_frames", limited);
+    uint16_t xfadeSram, xfadeTicks;
+    getXFadeStats(&xfadeSram, &xfadeTicks);
+    printStat("xfade_sram", xfadeSram);
+    printStat("xfade_max_us", (uint32_t)xfadeTicks * TIMER_TICK_US);
+    uint32_t chaseHits, chaseMisses;
+    getChaseStats(&chaseHits, &chaseMisses);
+    printStat("chase_hits", chaseHits);
+    printStat("chase_misses", chaseMisses);
+    uint32_t frames, rendered;
+    getRateStats(&frames, &rendered);
+    printStat("frames", frames);
+    printStat("rendered_frames", rendered);
+    printStat("passthrough_frames", sPassFrames);
+    printStat("lamp_latency_avg_us", sLatencyNum ? ((sLatencySum * TIMER_TICK_US) / sLatencyNum) : 0);
+    printStat("lamp_latency_max_us", (uint32_t)sLatencyMax * TIMER_TICK_US);
+    uint32_t govFrames[GOV_LEVELS], govLate;
+    getGovStats(govFrames, &govLate);
+    printStat("gov_full_frames", govFrames[GOV_FULL]);
+    printStat("gov_no_sparkles_frames", govFrames[GOV_NO_SPARKLES]);
+    printStat("gov_bg_reuse_frames", govFrames[GOV_BG_REUSE]);
+    printStat("gov_no_dither_frames", govFrames[GOV_NO_DITHER]);
+    printStat("gov_late_frames", govLate);
+#ifdef FRAME_MIRROR
+    printStat("mirror_dropped", mirrorDropped());
+#endif
+    uartPuts("END\n");
+}
@@ -0,0 +1,88 @@
+/***********************************************************************
+ *    _   _   _             _     __                                           
+ *   /_\ | |_| |_ __ _  ___| | __/ _|_ __ ___  _ __ ___   /\/\   __ _ _ __ ___ 
+ *  //_\\| __| __/ _` |/ __| |/ / |_| '__/ _ \| '_ ` _ \ /    \ / _` | '__/ __|
+ * /  _  \ |_| || (_| | (__|   <|  _| | | (_) | | | | | / /\/\ \ (_| | |  \__ \
+ * \_/ \_/\__|\__\__,_|\___|_|\_\_| |_|  \___/|_| |_| |_\/    \/\__,_|_|  |___/
+ *
+ *                              ____ ____ ___ 
+ *                              |--< |__, |==]
+ *
+ *                      ____ ____ _  _ ____ ____ ____
+ *                      ==== |--| |__| |___ |=== |--<
+ *
+ *  Copyright (c) 2022 bitfield labs
+ * 
+ ***********************************************************************
+ *  This file is part of the Attack from Mars! RGB saucer project:
+ *  https://github.com/bitfieldlabs/afm_saucer
+ *
+ *  The AfM RGB saucer is free software: you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public License as
+ *  published by the Free Software Foundation, either version 3 of the
+ *  License, or (at your option) any later version.
+ *
+ *  AfM RGB saucer is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with afterglow.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ ***********************************************************************/
+
+#include <avr/io.h>
+#include <stdbool.h>
+
+#define EVENT_QUEUE_SIZE 16     // number of queued events   ** CHOOSE A POWER OF 2 **
+
+_Static_assert((EVENT_QUEUE_SIZE & (EVENT_QUEUE_SIZE - 1)) == 0, "EVENT_QUEUE_SIZE must be a power of 2");
+
+// event types
+typedef enum EVENT_TYPE_e
+{
+    EV_FLASH = 0,       // flasher line falling edge
+    EV_SHAKER,          // shaker line change, data holds the new line level
+    EV_LAMPS,           // changed lamp frame completely shifted in, data holds the raw lamp state
+    EV_CONFIG           // DIP switch change, data holds the configuration id
+} EVENT_TYPE_t;
+
+typedef struct EVENT_s
+{
+    uint8_t type;       // EVENT_TYPE_t
+    uint16_t time;      // timer ticks when the event occurred
+    uint16_t data;      // event data
+} EVENT_t;
+
+// Single producer (all interrupts, which never nest) single consumer (main
+// loop) ring buffer. Only the producer writes the head, only the consumer
+// writes the tail, so no locking is required.
+extern EVENT_t sEvents[EVENT_QUEUE_SIZE];
+extern volatile uint8_t svEventHead;
+extern volatile uint8_t svEventTail;
+extern volatile uint8_t svEventsLost;
+
+//------------------------------------------------------------------------------
+// Queue an event. Interrupt context only, inlined to keep the ISRs short.
+// Returns false if the queue was full and the event dropped.
+static inline bool eventPush(uint8_t type, uint16_t data)
+{
+    uint8_t h = svEventHead;
+    uint8_t next = ((h + 1) & (EVENT_QUEUE_SIZE - 1));
+    if (next == svEventTail)
+    {
+        // queue full, drop the event
+        svEventsLost++;
+        return false;
+    }
+    EVENT_t *ev = &sEvents[h];
+    ev->type = type;
+    ev->time = TCNT1;
+    ev->data = data;
+    asm volatile ("" ::: "memory");     // publish the event only after it has been written
+    svEventHead = next;
+    return true;
+}
+
+bool eventPop(EVENT_t *ev);
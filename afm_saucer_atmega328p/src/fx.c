@@ -0,0 +1,211 @@
+/***********************************************************************
+ *    _   _   _             _     __                                           
+ *   /_\ | |_| |_ __ _  ___| | __/ _|_ __ ___  _ __ ___   /\/\   __ _ _ __ ___ 
+ *  //_\\| __| __/ _` |/ __| |/ / |_| '__/ _ \| '_ ` _ \ /    \ / _` | '__/ __|
+ * /  _  \ |_| || (_| | (__|   <|  _| | | (_) | | | | | / /\/\ \ (_| | |  \__ \
+ * \_/ \_/\__|\__\__,_|\___|_|\_\_| |_|  \___/|_| |_| |_\/    \/\__,_|_|  |___/
+ *
+ *                              ____ ____ ___ 
+ *                              |--< |__, |==]
+ *
+ *                      ____ ____ _  _ ____ ____ ____
+ *                      ==== |--| |__| |___ |=== |--<
+ *
+ *  Copyright (c) 2022 bitfield labs
+ * 
+ ***********************************************************************
+ *  This file is part of the Attack from Mars! RGB saucer project:
+ *  https://github.com/bitfieldlabs/afm_saucer
+ *
+ *  The AfM RGB saucer is free software: you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public License as
+ *  published by the Free Software Foundation, either version 3 of the
+ *  License, or (at your option) any later version.
+ *
+ *  AfM RGB saucer is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with afterglow.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ ***********************************************************************/
+
+#include <string.h>
+#include "fx.h"
+#include "modes.h"
+#include "utils.h"
+#include "layers.h"
+#include "geometry.h"
+
+#ifdef FEATURE_FX
+
+
+//------------------------------------------------------------------------------
+// definitions
+
+#define FX_SAT 160                  // effect colour saturation, towards white
+
+#define SHOCK_SPEED 48              // shockwave front speed [radius per frame]
+#define SHOCK_END 511               // shockwave front radius after the trail left the outermost LED
+
+#define SWEEP_SPEED 4               // sweep beam speed [angle per frame]
+#define SWEEP_TAIL 64               // sweep beam tail length [angle]   ** CHOOSE A POWER OF 2 **
+#define SWEEP_VALUE 160             // sweep beam brightness
+
+#define RIPPLE_FADE 160             // ripple brightness kept per frame
+#define RIPPLE_SPREAD 96            // ripple brightness passed on to the neighbours per frame
+
+
+//------------------------------------------------------------------------------
+// global variables
+
+static uint16_t sShockFront = 0;               // shockwave front radius, 0 if inactive
+static uint8_t sShockHue = 0;                  // shockwave hue
+static bool sSweep = false;                    // sweep beam on
+static uint8_t sSweepAngle = 0;                // sweep beam angle
+static uint8_t sSweepHue = 0;                  // sweep beam hue
+static uint8_t sRipple[NUM_LEDS] = { 0 };      // ripple brightness per LED
+static uint8_t sRippleHue = 0;                 // ripple hue
+static bool sRippleActive = false;             // any ripple brightness left
+
+
+//------------------------------------------------------------------------------
+void fxShockwave(uint8_t hue, uint16_t age)
+{
+    // The front starts one step inside the innermost LED, so the next frame
+    // shows it lighting up, and has travelled since the flasher edge age
+    // [1/256 frames] ago.
+    uint8_t inner = 255;
+    for (uint8_t i=0; i<NUM_LEDS; i++)
+    {
+        uint8_t r = geoRadius(i);
+        if (r < inner)
+        {
+            inner = r;
+        }
+    }
+    uint16_t start = (inner > SHOCK_SPEED) ? (inner - SHOCK_SPEED) : 1;
+    uint32_t front = start + (((uint32_t)SHOCK_SPEED * age) >> 8);
+    sShockFront = (front > SHOCK_END) ? 0 : front;
+    sShockHue = hue;
+}
+
+//------------------------------------------------------------------------------
+void fxSweep(bool on, uint8_t hue)
+{
+    sSweep = on;
+    sSweepHue = hue;
+}
+
+//------------------------------------------------------------------------------
+void fxRipple(uint8_t led, uint8_t hue)
+{
+    sRipple[led] = 255;
+    sRippleHue = hue;
+    sRippleActive = true;
+}
+
+//------------------------------------------------------------------------------
+void fxClear()
+{
+    sShockFront = 0;
+    sSweep = false;
+    memset(sRipple, 0, sizeof(sRipple));
+    sRippleActive = false;
+}
+
+//------------------------------------------------------------------------------
+void fxAdvance()
+{
+    if (sShockFront)
+    {
+        sShockFront += SHOCK_SPEED;
+        if (sShockFront > SHOCK_END)
+        {
+            sShockFront = 0;
+        }
+    }
+    sSweepAngle += SWEEP_SPEED;
+
+    // every LED fades and takes over the spread brightness of its neighbours,
+    // the ripple doesn't cross gaps in the ring
+    if (sRippleActive)
+    {
+        uint8_t next[NUM_LEDS];
+        sRippleActive = false;
+        for (uint8_t i=0; i<NUM_LEDS; i++)
+        {
+            uint8_t v = scale8(sRipple[i], RIPPLE_FADE);
+            uint8_t n = geoPrev(i);
+            if ((n != GEO_NONE) && (scale8(sRipple[n], RIPPLE_SPREAD) > v))
+            {
+                v = scale8(sRipple[n], RIPPLE_SPREAD);
+            }
+            n = geoNext(i);
+            if ((n != GEO_NONE) && (scale8(sRipple[n], RIPPLE_SPREAD) > v))
+            {
+                v = scale8(sRipple[n], RIPPLE_SPREAD);
+            }
+            next[i] = v;
+            if (v)
+            {
+                sRippleActive = true;
+            }
+        }
+        memcpy(sRipple, next, sizeof(sRipple));
+    }
+}
+
+//------------------------------------------------------------------------------
+bool fxActive()
+{
+    return (sShockFront || sSweep || sRippleActive);
+}
+
+//------------------------------------------------------------------------------
+void fxRender(FRAME_t *f, uint8_t blend)
+{
+    // one colour per effect, the brightness of each LED is the alpha
+    uint8_t r, g, b;
+    if (sShockFront)
+    {
+        // bright at the front, fading behind it
+        hsv2rgb(sShockHue, FX_SAT, 255, &r, &g, &b);
+        for (uint8_t i=0; i<NUM_LEDS; i++)
+        {
+            int16_t d = (sShockFront - geoRadius(i));
+            if ((d >= 0) && (d < 256))
+            {
+                layerPixel(f, i, r, g, b, blend, (255 - d));
+            }
+        }
+    }
+    if (sSweep)
+    {
+        // beam with a tail behind it
+        hsv2rgb(sSweepHue, FX_SAT, SWEEP_VALUE, &r, &g, &b);
+        for (uint8_t i=0; i<NUM_LEDS; i++)
+        {
+            uint8_t d = (sSweepAngle - geoAngle(i));
+            if (d < SWEEP_TAIL)
+            {
+                layerPixel(f, i, r, g, b, blend, (255 - (d * (256 / SWEEP_TAIL))));
+            }
+        }
+    }
+    if (sRippleActive)
+    {
+        hsv2rgb(sRippleHue, FX_SAT, 255, &r, &g, &b);
+        for (uint8_t i=0; i<NUM_LEDS; i++)
+        {
+            if (sRipple[i])
+            {
+                layerPixel(f, i, r, g, b, blend, sRipple[i]);
+            }
+        }
+    }
+}
+
+#endif
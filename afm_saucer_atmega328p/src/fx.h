@@ -0,0 +1,66 @@
+/***********************************************************************
+ *    _   _   _             _     __                                           
+ *   /_\ | |_| |_ __ _  ___| | __/ _|_ __ ___  _ __ ___   /\/\   __ _ _ __ ___ 
+ *  //_\\| __| __/ _` |/ __| |/ / |_| '__/ _ \| '_ ` _ \ /    \ / _` | '__/ __|
+ * /  _  \ |_| || (_| | (__|   <|  _| | | (_) | | | | | / /\/\ \ (_| | |  \__ \
+ * \_/ \_/\__|\__\__,_|\___|_|\_\_| |_|  \___/|_| |_| |_\/    \/\__,_|_|  |___/
+ *
+ *                              ____ ____ ___ 
+ *                              |--< |__, |==]
+ *
+ *                      ____ ____ _  _ ____ ____ ____
+ *                      ==== |--| |__| |___ |=== |--<
+ *
+ *  Copyright (c) 2022 bitfield labs
+ * 
+ ***********************************************************************
+ *  This file is part of the Attack from Mars! RGB saucer project:
+ *  https://github.com/bitfieldlabs/afm_saucer
+ *
+ *  The AfM RGB saucer is free software: you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public License as
+ *  published by the Free Software Foundation, either version 3 of the
+ *  License, or (at your option) any later version.
+ *
+ *  AfM RGB saucer is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with afterglow.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ ***********************************************************************/
+
+#include <avr/io.h>
+#include <stdbool.h>
+#include "options.h"
+
+// geometric effects, flags for LED_MODE_t.effects
+typedef enum FX_e
+{
+    FX_SHOCKWAVE = 0x01,    // flasher shockwave from the saucer centre
+    FX_SWEEP = 0x02,        // beam sweeping around the saucer
+    FX_RIPPLE = 0x04        // glow spreading from lamps turning on to their neighbours
+} FX_t;
+
+struct FRAME_s;
+
+#ifdef FEATURE_FX
+void fxShockwave(uint8_t hue, uint16_t age);
+void fxSweep(bool on, uint8_t hue);
+void fxRipple(uint8_t led, uint8_t hue);
+void fxClear();
+void fxAdvance();
+bool fxActive();
+void fxRender(struct FRAME_s *f, uint8_t blend);
+#else
+// no geometric effects, see options.h
+static inline void fxShockwave(uint8_t hue, uint16_t age) {}
+static inline void fxSweep(bool on, uint8_t hue) {}
+static inline void fxRipple(uint8_t led, uint8_t hue) {}
+static inline void fxClear() {}
+static inline void fxAdvance() {}
+static inline bool fxActive() { return false; }
+static inline void fxRender(struct FRAME_s *f, uint8_t blend) {}
+#endif
@@ -0,0 +1,62 @@
+/***********************************************************************
+ *    _   _   _             _     __                                           
+ *   /_\ | |_| |_ __ _  ___| | __/ _|_ __ ___  _ __ ___   /\/\   __ _ _ __ ___ 
+ *  //_\\| __| __/ _` |/ __| |/ / |_| '__/ _ \| '_ ` _ \ /    \ / _` | '__/ __|
+ * /  _  \ |_| || (_| | (__|   <|  _| | | (_) | | | | | / /\/\ \ (_| | |  \__ \
+ * \_/ \_/\__|\__\__,_|\___|_|\_\_| |_|  \___/|_| |_| |_\/    \/\__,_|_|  |___/
+ *
+ *                              ____ ____ ___ 
+ *                              |--< |__, |==]
+ *
+ *                      ____ ____ _  _ ____ ____ ____
+ *                      ==== |--| |__| |___ |=== |--<
+ *
+ *  Copyright (c) 2022 bitfield labs
+ * 
+ ***********************************************************************
+ *  This file is part of the Attack from Mars! RGB saucer project:
+ *  https://github.com/bitfieldlabs/afm_saucer
+ *
+ *  The AfM RGB saucer is free software: you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public License as
+ *  published by the Free Software Foundation, either version 3 of the
+ *  License, or (at your option) any later version.
+ *
+ *  AfM RGB saucer is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with afterglow.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ ***********************************************************************/
+
+// Generated from led_pos.ods by tools/gen_geometry.py, do not edit
+
+#include <avr/pgmspace.h>
+#include "modes.h"
+#include "geometry.h"
+
+
+//------------------------------------------------------------------------------
+const GEOMETRY_t skGeometry[NUM_LEDS] PROGMEM =
+{
+    // angle, radius, prev, next
+    {  15, 255, 0xff, 0x01 },   // LED 0
+    {  30, 255, 0x00, 0x02 },   // LED 1
+    {  45, 255, 0x01, 0x03 },   // LED 2
+    {  60, 255, 0x02, 0x04 },   // LED 3
+    {  75, 255, 0x03, 0x05 },   // LED 4
+    {  90, 255, 0x04, 0x06 },   // LED 5
+    { 105, 255, 0x05, 0x07 },   // LED 6
+    { 120, 255, 0x06, 0x08 },   // LED 7
+    { 136, 255, 0x07, 0x09 },   // LED 8
+    { 151, 255, 0x08, 0x0a },   // LED 9
+    { 166, 255, 0x09, 0x0b },   // LED 10
+    { 181, 255, 0x0a, 0x0c },   // LED 11
+    { 196, 255, 0x0b, 0x0d },   // LED 12
+    { 211, 255, 0x0c, 0x0e },   // LED 13
+    { 226, 255, 0x0d, 0x0f },   // LED 14
+    { 241, 255, 0x0e, 0xff },   // LED 15
+};
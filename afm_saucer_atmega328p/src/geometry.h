@@ -0,0 +1,74 @@
+/***********************************************************************
+ *    _   _   _             _     __                                           
+ *   /_\ | |_| |_ __ _  ___| | __/ _|_ __ ___  _ __ ___   /\/\   __ _ _ __ ___ 
+ *  //_\\| __| __/ _` |/ __| |/ / |_| '__/ _ \| '_ ` _ \ /    \ / _` | '__/ __|
+ * /  _  \ |_| || (_| | (__|   <|  _| | | (_) | | | | | / /\/\ \ (_| | |  \__ \
+ * \_/ \_/\__|\__\__,_|\___|_|\_\_| |_|  \___/|_| |_| |_\/    \/\__,_|_|  |___/
+ *
+ *                              ____ ____ ___ 
+ *                              |--< |__, |==]
+ *
+ *                      ____ ____ _  _ ____ ____ ____
+ *                      ==== |--| |__| |___ |=== |--<
+ *
+ *  Copyright (c) 2022 bitfield labs
+ * 
+ ***********************************************************************
+ *  This file is part of the Attack from Mars! RGB saucer project:
+ *  https://github.com/bitfieldlabs/afm_saucer
+ *
+ *  The AfM RGB saucer is free software: you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public License as
+ *  published by the Free Software Foundation, either version 3 of the
+ *  License, or (at your option) any later version.
+ *
+ *  AfM RGB saucer is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with afterglow.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ ***********************************************************************/
+
+#include <avr/io.h>
+#include <avr/pgmspace.h>
+
+#define GEO_NONE 0xff           // no neighbour on this side (gap in the ring)
+
+// physical position of a saucer LED, generated from led_pos.ods by
+// tools/gen_geometry.py, needs NUM_LEDS from modes.h
+typedef struct GEOMETRY_s
+{
+    uint8_t angle;      // polar angle in ring index direction, 256 is a full turn, 0 at the top
+    uint8_t radius;     // distance from the saucer centre, 255 is the outermost LED
+    uint8_t prev;       // previous LED along the ring, GEO_NONE if not adjacent
+    uint8_t next;       // next LED along the ring, GEO_NONE if not adjacent
+} GEOMETRY_t;
+
+extern const GEOMETRY_t skGeometry[NUM_LEDS] PROGMEM;
+
+//------------------------------------------------------------------------------
+static inline uint8_t geoAngle(uint8_t led)
+{
+    return pgm_read_byte(&skGeometry[led].angle);
+}
+
+//------------------------------------------------------------------------------
+static inline uint8_t geoRadius(uint8_t led)
+{
+    return pgm_read_byte(&skGeometry[led].radius);
+}
+
+//------------------------------------------------------------------------------
+static inline uint8_t geoPrev(uint8_t led)
+{
+    return pgm_read_byte(&skGeometry[led].prev);
+}
+
+//------------------------------------------------------------------------------
+static inline uint8_t geoNext(uint8_t led)
+{
+    return pgm_read_byte(&skGeometry[led].next);
+}
@@ -0,0 +1,116 @@
+/***********************************************************************
+ *    _   _   _             _     __                                           
+ *   /_\ | |_| |_ __ _  ___| | __/ _|_ __ ___  _ __ ___   /\/\   __ _ _ __ ___ 
+ *  //_\\| __| __/ _` |/ __| |/ / |_| '__/ _ \| '_ ` _ \ /    \ / _` | '__/ __|
+ * /  _  \ |_| || (_| | (__|   <|  _| | | (_) | | | | | / /\/\ \ (_| | |  \__ \
+ * \_/ \_/\__|\__\__,_|\___|_|\_\_| |_|  \___/|_| |_| |_\/    \/\__,_|_|  |___/
+ *
+ *                              ____ ____ ___ 
+ *                              |--< |__, |==]
+ *
+ *                      ____ ____ _  _ ____ ____ ____
+ *                      ==== |--| |__| |___ |=== |--<
+ *
+ *  Copyright (c) 2022 bitfield labs
+ * 
+ ***********************************************************************
+ *  This file is part of the Attack from Mars! RGB saucer project:
+ *  https://github.com/bitfieldlabs/afm_saucer
+ *
+ *  The AfM RGB saucer is free software: you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public License as
+ *  published by the Free Software Foundation, either version 3 of the
+ *  License, or (at your option) any later version.
+ *
+ *  AfM RGB saucer is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with afterglow.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ ***********************************************************************/
+
+#include "governor.h"
+#include "timer.h"
+
+#ifdef FEATURE_GOVERNOR
+
+
+//------------------------------------------------------------------------------
+// definitions
+
+#define GOV_DEADLINE (8000 / TIMER_TICK_US)         // rendering has to end this long after the frame start, before the dithering refresh [ticks]
+#define GOV_TIGHT (GOV_DEADLINE * 3 / 4)            // degrade one level above this render time [ticks]
+#define GOV_RELAXED (GOV_DEADLINE / 2)              // render time allowing to restore a level [ticks]
+#define GOV_RELAX_FRAMES 32                         // relaxed frames before restoring one level
+
+
+//------------------------------------------------------------------------------
+// global variables
+
+static uint8_t sLevel = GOV_FULL;              // current degradation level
+static uint8_t sRelaxed = 0;                   // consecutive relaxed frames
+static uint32_t sLevelFrames[GOV_LEVELS] = { 0 };  // rendered frames per level
+static uint32_t sLate = 0;                     // frames which missed the deadline
+
+
+//------------------------------------------------------------------------------
+void govStart(uint16_t frameStart)
+{
+    // the timer 1 compare flag marks the deadline, even if the frame stalls
+    // for longer than a timer period
+    OCR1A = (frameStart + GOV_DEADLINE);
+    TIFR1 = (1 << OCF1A);
+}
+
+//------------------------------------------------------------------------------
+uint8_t govEnd(uint16_t renderTicks)
+{
+    // Degrade right away to the last level after a missed deadline, one
+    // level if the frame got tight. Levels are only restored one by one
+    // after a while with enough headroom. Returns the level for the next
+    // frame.
+    sLevelFrames[sLevel]++;
+    if ((TIFR1 & (1 << OCF1A)) || (renderTicks >= GOV_DEADLINE))
+    {
+        sLate++;
+        sLevel = (GOV_LEVELS - 1);
+        sRelaxed = 0;
+    }
+    else if (renderTicks > GOV_TIGHT)
+    {
+        if (sLevel < (GOV_LEVELS - 1))
+        {
+            sLevel++;
+        }
+        sRelaxed = 0;
+    }
+    else if ((renderTicks < GOV_RELAXED) && (sLevel > GOV_FULL))
+    {
+        sRelaxed++;
+        if (sRelaxed >= GOV_RELAX_FRAMES)
+        {
+            sLevel--;
+            sRelaxed = 0;
+        }
+    }
+    else
+    {
+        sRelaxed = 0;
+    }
+    return sLevel;
+}
+
+//------------------------------------------------------------------------------
+void getGovStats(uint32_t *levelFrames, uint32_t *late)
+{
+    for (uint8_t i=0; i<GOV_LEVELS; i++)
+    {
+        levelFrames[i] = sLevelFrames[i];
+    }
+    *late = sLate;
+}
+
+#endif
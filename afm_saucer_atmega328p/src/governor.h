@@ -0,0 +1,65 @@
+/***********************************************************************
+ *    _   _   _             _     __                                           
+ *   /_\ | |_| |_ __ _  ___| | __/ _|_ __ ___  _ __ ___   /\/\   __ _ _ __ ___ 
+ *  //_\\| __| __/ _` |/ __| |/ / |_| '__/ _ \| '_ ` _ \ /    \ / _` | '__/ __|
+ * /  _  \ |_| || (_| | (__|   <|  _| | | (_) | | | | | / /\/\ \ (_| | |  \__ \
+ * \_/ \_/\__|\__\__,_|\___|_|\_\_| |_|  \___/|_| |_| |_\/    \/\__,_|_|  |___/
+ *
+ *                              ____ ____ ___ 
+ *                              |--< |__, |==]
+ *
+ *                      ____ ____ _  _ ____ ____ ____
+ *                      ==== |--| |__| |___ |=== |--<
+ *
+ *  Copyright (c) 2022 bitfield labs
+ * 
+ ***********************************************************************
+ *  This file is part of the Attack from Mars! RGB saucer project:
+ *  https://github.com/bitfieldlabs/afm_saucer
+ *
+ *  The AfM RGB saucer is free software: you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public License as
+ *  published by the Free Software Foundation, either version 3 of the
+ *  License, or (at your option) any later version.
+ *
+ *  AfM RGB saucer is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with afterglow.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ ***********************************************************************/
+
+#include <avr/io.h>
+#include "options.h"
+
+// render degradation levels, each one includes all before
+typedef enum GOV_LEVEL_e
+{
+    GOV_FULL = 0,       // everything rendered
+    GOV_NO_SPARKLES,    // no shaker sparkles, the particles are not drawn
+    GOV_BG_REUSE,       // the previous background colours are reused
+    GOV_NO_DITHER,      // no temporal dithering refresh
+
+    GOV_LEVELS          // number of levels
+} GOV_LEVEL_t;
+
+#ifdef FEATURE_GOVERNOR
+void govStart(uint16_t frameStart);
+uint8_t govEnd(uint16_t renderTicks);
+void getGovStats(uint32_t *levelFrames, uint32_t *late);
+#else
+// no governor, every frame is rendered in full, see options.h
+static inline void govStart(uint16_t frameStart) {}
+static inline uint8_t govEnd(uint16_t renderTicks) { return GOV_FULL; }
+static inline void getGovStats(uint32_t *levelFrames, uint32_t *late)
+{
+    for (uint8_t i=0; i<GOV_LEVELS; i++)
+    {
+        levelFrames[i] = 0;
+    }
+    *late = 0;
+}
+#endif
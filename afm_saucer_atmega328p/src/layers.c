@@ -0,0 +1,71 @@
+/***********************************************************************
+ *    _   _   _             _     __                                           
+ *   /_\ | |_| |_ __ _  ___| | __/ _|_ __ ___  _ __ ___   /\/\   __ _ _ __ ___ 
+ *  //_\\| __| __/ _` |/ __| |/ / |_| '__/ _ \| '_ ` _ \ /    \ / _` | '__/ __|
+ * /  _  \ |_| || (_| | (__|   <|  _| | | (_) | | | | | / /\/\ \ (_| | |  \__ \
+ * \_/ \_/\__|\__\__,_|\___|_|\_\_| |_|  \___/|_| |_| |_\/    \/\__,_|_|  |___/
+ *
+ *                              ____ ____ ___ 
+ *                              |--< |__, |==]
+ *
+ *                      ____ ____ _  _ ____ ____ ____
+ *                      ==== |--| |__| |___ |=== |--<
+ *
+ *  Copyright (c) 2022 bitfield labs
+ * 
+ ***********************************************************************
+ *  This file is part of the Attack from Mars! RGB saucer project:
+ *  https://github.com/bitfieldlabs/afm_saucer
+ *
+ *  The AfM RGB saucer is free software: you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public License as
+ *  published by the Free Software Foundation, either version 3 of the
+ *  License, or (at your option) any later version.
+ *
+ *  AfM RGB saucer is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with afterglow.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ ***********************************************************************/
+
+#include "modes.h"
+#include "layers.h"
+#include "utils.h"
+
+
+//------------------------------------------------------------------------------
+static uint8_t blendChannel(uint8_t dst, uint8_t src, uint8_t blend, uint8_t alpha)
+{
+    if (alpha == 255)
+    {
+        // opaque, the common case
+        switch (blend)
+        {
+            case BLEND_ADD: return qadd8(dst, src);
+            case BLEND_MAX: return (src > dst) ? src : dst;
+            default: return src;
+        }
+    }
+    switch (blend)
+    {
+        case BLEND_ADD:
+            return qadd8(dst, scale8(src, alpha));
+        case BLEND_MAX:
+            src = scale8(src, alpha);
+            return (src > dst) ? src : dst;
+        default:
+            return blend8(dst, src, alpha);
+    }
+}
+
+//------------------------------------------------------------------------------
+void layerPixel(FRAME_t *f, uint8_t i, uint8_t r, uint8_t g, uint8_t b, uint8_t blend, uint8_t alpha)
+{
+    frameChannel(f, &f->r[i], blendChannel(f->r[i], r, blend, alpha));
+    frameChannel(f, &f->g[i], blendChannel(f->g[i], g, blend, alpha));
+    frameChannel(f, &f->b[i], blendChannel(f->b[i], b, blend, alpha));
+}
@@ -0,0 +1,71 @@
+/***********************************************************************
+ *    _   _   _             _     __                                           
+ *   /_\ | |_| |_ __ _  ___| | __/ _|_ __ ___  _ __ ___   /\/\   __ _ _ __ ___ 
+ *  //_\\| __| __/ _` |/ __| |/ / |_| '__/ _ \| '_ ` _ \ /    \ / _` | '__/ __|
+ * /  _  \ |_| || (_| | (__|   <|  _| | | (_) | | | | | / /\/\ \ (_| | |  \__ \
+ * \_/ \_/\__|\__\__,_|\___|_|\_\_| |_|  \___/|_| |_| |_\/    \/\__,_|_|  |___/
+ *
+ *                              ____ ____ ___ 
+ *                              |--< |__, |==]
+ *
+ *                      ____ ____ _  _ ____ ____ ____
+ *                      ==== |--| |__| |___ |=== |--<
+ *
+ *  Copyright (c) 2022 bitfield labs
+ * 
+ ***********************************************************************
+ *  This file is part of the Attack from Mars! RGB saucer project:
+ *  https://github.com/bitfieldlabs/afm_saucer
+ *
+ *  The AfM RGB saucer is free software: you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public License as
+ *  published by the Free Software Foundation, either version 3 of the
+ *  License, or (at your option) any later version.
+ *
+ *  AfM RGB saucer is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with afterglow.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ ***********************************************************************/
+
+#include <avr/io.h>
+#include <stdbool.h>
+
+// layer blend modes, alpha 255 means fully opaque
+typedef enum BLEND_e
+{
+    BLEND_NORMAL = 0,   // mix over the layers below by alpha
+    BLEND_ADD,          // add, saturating
+    BLEND_MAX           // keep the brighter channel
+} BLEND_t;
+
+#define AG_FULL 255     // afterglow blend of a fully lit saucer LED
+
+// frame being composed, needs NUM_PIXELS from modes.h
+typedef struct FRAME_s
+{
+    uint8_t r[NUM_PIXELS];
+    uint8_t g[NUM_PIXELS];
+    uint8_t b[NUM_PIXELS];
+    uint8_t ag[NUM_LEDS];       // foreground afterglow blend per saucer LED, AG_FULL when lit
+    uint8_t lit;                // number of saucer LEDs with an afterglow blend
+    uint16_t sum;               // sum of all channel values, kept up to date by every write
+} FRAME_t;
+
+// Every layer has a visibility test, false if fully transparent this frame,
+// and a render function drawing with layerPixel() in the given blend mode.
+// renderLEDs() calls them bottom up in their fixed order.
+
+//------------------------------------------------------------------------------
+static inline void frameChannel(FRAME_t *f, uint8_t *c, uint8_t v)
+{
+    // write a channel of f, the current estimation needs no extra pass
+    f->sum += (uint16_t)(v - *c);
+    *c = v;
+}
+
+void layerPixel(FRAME_t *f, uint8_t i, uint8_t r, uint8_t g, uint8_t b, uint8_t blend, uint8_t alpha);
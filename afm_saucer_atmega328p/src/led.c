@@ -34,6 +34,9 @@
 
 #include "led.h"
 #include <avr/interrupt.h>
+#ifdef SIMAVR_TRACE
+#include "sim.h"
+#endif
 
 
 // Code by josh.com
@@ -206,6 +209,9 @@ void sendPixel(uint8_t r, uint8_t g, uint8_t b, bool firstString)
     sendByte(r, firstString);
     sendByte(g, firstString);
     sendByte(b, firstString);
+#ifdef SIMAVR_TRACE
+    simPixel(r, g, b);
+#endif
 }
 
 
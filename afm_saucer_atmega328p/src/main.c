@@ -35,28 +35,145 @@
 #include <avr/io.h>
 #include <avr/interrupt.h>
 #include <avr/eeprom.h>
-#include <util/delay.h>
+#include <avr/wdt.h>
 #include <stdlib.h>
 #include <stdbool.h>
 #include "modes.h"
+#include "timer.h"
+#include "uart.h"
+#include "events.h"
+#include "nvm.h"
+#include "usage.h"
+#include "governor.h"
+#ifdef TRACE_RECORDER
+#include "trace.h"
+#endif
+#ifdef SAUCER_DEBUG
+#include "debug.h"
+#include "stack.h"
+#endif
+#ifdef SIMAVR_TRACE
+#include "sim.h"
+#endif
+#ifdef FRAME_MIRROR
+#include "mirror.h"
+#endif
 
 
 //------------------------------------------------------------------------------
 // definitions
 
-#define LED_UPDATE_INT 20                   // LED update interval [ms]
-#define FLASH_CONS_CHECK 1                  // number of consecutive flash line checks in LED_UPDATE_INT interval required for flash triggering
+#define LED_UPDATE_INT 20                   // base LED update interval, the animation time step [ms]
+#define FRAME_TICKS (LED_UPDATE_INT * 1000UL / TIMER_TICK_US)  // base LED update interval [ticks]
+#define DITHER_ON_LOAD 40                   // enable dithering below this frame load [%]
+#define DITHER_OFF_LOAD 60                  // disable dithering above this frame load [%]
+#define WATCHDOG_TIMEOUT WDTO_250MS          // watchdog reset if the frame loop stalls for this long
+#define LAMP_FRAME_GAP (1000 / TIMER_TICK_US)   // lamp clock pause starting a new lamp frame [ticks]
+#define TRACE_KEEPALIVE 12                  // record the lamp state every TRACE_KEEPALIVE frames to keep the time base, less than a timer period (262ms)
+#define PASS_MIN_TICKS (1000 / TIMER_TICK_US)   // shortest interval between passthrough renders, string wire time and latch [ticks]
+#define PASS_DEFER_MAX 4                    // other events the passthrough puts aside for the next frame
 
 
 //------------------------------------------------------------------------------
 // global variables
 
-static volatile uint16_t svLEDState = 0xffff;    // status for all 16 LEDs
-static volatile bool svFlashState = false;       // flasher status
-static volatile bool svShakerState = false;      // shaker status
-static volatile uint16_t svFlashCounter = 0;     // consecutive passed flash line checks counter
+static volatile uint16_t svLEDState = 0xffff;    // lamp shift register, only complete frames are reported
+static uint16_t sLampFrame = 0xffff;             // last completely shifted in lamp frame
+static uint16_t sLampClockTime = 0;              // time of the last lamp clock [ticks]
+static uint8_t sLampBits = 0;                    // lamp bits shifted into the current frame
+static volatile bool svConfigLost = false;       // a DIP switch change didn't fit into the event queue
+static bool sDither = false;                     // temporal dithering refresh active
+static uint8_t sRenderLevel = GOV_FULL;          // render degradation level chosen by the governor
+static uint16_t sDitherTicks = 0;                // duration of the last dithering refresh [ticks]
+static uint8_t sResetFlags __attribute__ ((section (".noinit")));  // MCUSR at reset
+static uint32_t sSeed = 0;                       // random seed for the next start, written in the background
+static uint16_t sPassStart = 0;                  // start of the last passthrough render [ticks]
+static uint16_t sPassTicks = 0;                  // duration of the last passthrough render [ticks]
+static EVENT_t sPassDeferred[PASS_DEFER_MAX];    // other events taken from the queue by the passthrough
+static uint8_t sPassDeferredNum = 0;             // number of events in sPassDeferred
+#ifdef TRACE_RECORDER
+static uint8_t sTraceKeepalive = 1;              // frames until the LED status is recorded again
+#endif
 
 
+//------------------------------------------------------------------------------
+// declarations
+
+void saveResetFlags(void) __attribute__ ((naked, used, section (".init3")));
+static uint8_t passthrough(uint16_t frameEnd, uint16_t *ledState) __attribute__ ((noinline));  // waiting time for tools/wcet.py
+
+
+//------------------------------------------------------------------------------
+void saveResetFlags(void)
+{
+    // The watchdog stays enabled after a watchdog reset, turn it off before it
+    // bites again during startup.
+    sResetFlags = MCUSR;
+    MCUSR = 0;
+    wdt_disable();
+}
+
+//------------------------------------------------------------------------------
+static uint8_t passthrough(uint16_t frameEnd, uint16_t *ledState)
+{
+    // Show the lamp frames arriving until the next animation frame right
+    // away. Renders are spaced by the wire time of the string and only start
+    // if they end before the frame. Other events are put aside for the frame,
+    // so they don't hold up the lamp frames behind them. Returns the number of
+    // lamp frames taken from the queue.
+    uint8_t lampEvents = 0;
+    bool pending = false;
+    while (true)
+    {
+        EVENT_t ev;
+        if ((sPassDeferredNum < PASS_DEFER_MAX) && eventPop(&ev))
+        {
+#ifdef TRACE_RECORDER
+            traceRecord(ev.type, ev.time, ev.data);
+#endif
+            if (ev.type == EV_LAMPS)
+            {
+#ifdef SIMAVR_TRACE
+                simLamps(ev.data);
+#endif
+#ifdef SAUCER_DEBUG
+                debugLampIn(ev.time);
+#endif
+                *ledState = ev.data;
+                lampEvents++;
+                pending = true;
+            }
+            else
+            {
+                sPassDeferred[sPassDeferredNum++] = ev;
+            }
+        }
+        uint16_t now = timerTicks();
+        int16_t left = (int16_t)(frameEnd - now);
+        if (left <= 0)
+        {
+            break;
+        }
+        if (pending && ((uint16_t)(now - sPassStart) >= PASS_MIN_TICKS) && (left > (int16_t)sPassTicks))
+        {
+#ifdef FRAME_MIRROR
+            mirrorBegin(*ledState, getMode());
+#endif
+            showLamps(*ledState);
+#ifdef FRAME_MIRROR
+            mirrorEnd();
+#endif
+            sPassStart = now;
+            sPassTicks = (timerTicks() - now);
+            pending = false;
+#ifdef SAUCER_DEBUG
+            debugLightOut(true);
+#endif
+        }
+    }
+    return lampEvents;
+}
+
 //------------------------------------------------------------------------------
 int main(void)
 {
@@ -70,51 +187,225 @@ int main(void)
     EIMSK |= (1 << INT1);                   // turn on INT1
     PCICR |= (1 << PCIE2);                  // enable pin interrupt
     PCMSK2 |= (1 << PCINT23);               // pin change interrupt on PD7 (PCINT23)
+    PCICR |= (1 << PCIE1);                  // enable pin interrupt
+    PCMSK1 |= 0b00001111;                   // pin change interrupt on the DIPs PC0-PC3 (PCINT8-11)
+    timerInit();
+#ifdef UART_ENABLED
+    uartInit();
+#endif
 
     // seed the random number generator
     uint32_t seed = eeprom_read_dword((uint32_t*)0);
     srand(seed);
-    eeprom_write_dword((uint32_t*)0, rand());
+
+    // After a watchdog or brown-out reset continue with the previous mode
+    // right away. Only a cold start plays the jingle and writes a new seed.
+    bool warmStart = false;
+    if (!(sResetFlags & (1 << PORF)) && (sResetFlags & ((1 << WDRF) | (1 << BORF))))
+    {
+        warmStart = restoreWarmState();
+    }
+    if (!warmStart)
+    {
+        // written by the EEPROM interrupt once they are enabled
+        sSeed = rand();
+        nvmWrite(0, &sSeed, sizeof(sSeed));
+    }
+
+    // persistent usage counters
+    usageInit(sResetFlags);
+
+    // initial configuration, changes are reported by the pin change interrupt
+    uint8_t cfg = (~PINC & 0x0f);
+    setConfig(cfg);
+#ifdef TRACE_RECORDER
+    traceRecord(EV_CONFIG, timerTicks(), cfg);
+#endif
+
+    // reset if the main loop gets stuck
+    wdt_enable(WATCHDOG_TIMEOUT);
 
     // enable interrupts
     sei();
 
     // to infinity and beyond
+    uint16_t frameStart = timerTicks();
+    uint16_t ledState = 0xffff;
+    uint8_t interval = 1;                   // base frames between renders
+    uint8_t steps = 0;                      // base frames since the last render
+    uint8_t lampEvents = 0;                 // lamp frames handled by the passthrough since the last frame
+    bool ditherRender = false;              // the last render was dithered
     while (true)
     {
-        // update the LED state upon change
-        updateLEDState(svLEDState);
-        if (svFlashState)
+        wdt_reset();
+
+        // handle all events since the last frame in order of occurrence, the
+        // ones put aside by the passthrough come first and are already traced
+        uint8_t events = lampEvents;
+        uint8_t deferred = 0;
+        EVENT_t ev;
+        while (true)
         {
-            // noise filtering: make sure the flash line is still kept low for at
-            // least FLASH_CONS_CHECK consecutive checks
-            if (!(PIND & 0b00001000))
+            if (deferred < sPassDeferredNum)
+            {
+                ev = sPassDeferred[deferred++];
+            }
+            else if (eventPop(&ev))
             {
-                svFlashCounter++;
-                if (svFlashCounter >= FLASH_CONS_CHECK)
-                {
-                    triggerFlasher();
-                    svFlashCounter = 0;
-                    svFlashState = false;
-                }
+#ifdef TRACE_RECORDER
+                traceRecord(ev.type, ev.time, ev.data);
+#endif
             }
             else
             {
-                svFlashCounter = 0;
-                svFlashState = false;
+                break;
+            }
+            events++;
+            switch (ev.type)
+            {
+                case EV_LAMPS:
+#ifdef SAUCER_DEBUG
+                    debugLampIn(ev.time);
+#endif
+                    ledState = ev.data;
+#ifdef SIMAVR_TRACE
+                    simLamps(ledState);
+#endif
+                    break;
+                case EV_FLASH:
+                    // noise filtering: the flash line has to be still low when
+                    // the event is handled, up to a frame after the edge
+                    if (!(PIND & (1 << PD3)))
+                    {
+                        triggerFlasher(ev.time);
+                        usageFlash();
+                    }
+                    break;
+                case EV_SHAKER: triggerShaker(ev.time); break;
+                case EV_CONFIG: setConfig(ev.data); break;
+                default: break;
             }
         }
-        if (svShakerState)
+        sPassDeferredNum = 0;
+        if (svConfigLost)
         {
-            triggerShaker();
-            svShakerState = false;
+            svConfigLost = false;
+            uint8_t cfg = (~PINC & 0x0f);
+            setConfig(cfg);
+#ifdef TRACE_RECORDER
+            traceRecord(EV_CONFIG, timerTicks(), cfg);
+#endif
         }
 
-        // update all LEDs
-        updateLEDs();
+        // update the LED state, the last complete lamp frame counts as the
+        // shift register may be in the middle of the next one
+        updateLEDState(ledState);
+#ifdef TRACE_RECORDER
+        // periodic lamp state record to keep the time base
+        sTraceKeepalive--;
+        if (sTraceKeepalive == 0)
+        {
+            traceRecord(EV_LAMPS, timerTicks(), ledState);
+            sTraceKeepalive = TRACE_KEEPALIVE;
+        }
+#endif
+
+        // usage counters, flushed to the EEPROM in the background
+        usageTime(getMode(), LED_UPDATE_INT);
+
+        // Render at the frame rate the scene activity asks for, but right
+        // away on any event. Skipped base frames are caught up in the next
+        // render.
+        steps++;
+        if (events || (steps >= interval))
+        {
+#ifdef SAUCER_DEBUG
+            // the stack ran into the static variables, latch the error colour
+            if (stackOverflow())
+            {
+                latchError();
+            }
+#endif
 
-        // wait a bit
-        _delay_ms(LED_UPDATE_INT);
+            // update all LEDs, with as much optional work as the governor
+            // allows
+            govStart(frameStart);
+            setRenderLevel(sRenderLevel);
+#ifdef FRAME_MIRROR
+            mirrorBegin(ledState, getMode());
+#endif
+            updateLEDs(steps);
+#ifdef FRAME_MIRROR
+            mirrorEnd();
+#endif
+#ifdef SAUCER_DEBUG
+            debugLightOut(false);
+#endif
+            uint16_t renderTicks = (timerTicks() - frameStart);
+            sRenderLevel = govEnd(renderTicks);
+            interval = frameInterval(events);
+            bool dither = (ditherRender && (sRenderLevel < GOV_NO_DITHER));
+
+            // Temporal dithering sends an extra refresh in the middle of the
+            // frame. It is only active while the frame load including the
+            // refresh leaves enough headroom, and is the last thing the
+            // governor drops. A lowered frame rate would leave the refresh on
+            // the LEDs for several base frames and bias the brightness, so
+            // the refresh before a longer interval is sent without dithering
+            // and the renders stay undithered until the full rate returns.
+            if (dither)
+            {
+                timerWaitUntil(frameStart + (FRAME_TICKS / 2));
+                uint16_t t = timerTicks();
+                setDither(interval == 1);
+                refreshLEDs();
+                sDitherTicks = (timerTicks() - t);
+            }
+            uint16_t load = (renderTicks + (sDither ? sDitherTicks : renderTicks));
+            if (load < (FRAME_TICKS * DITHER_ON_LOAD / 100))
+            {
+                sDither = true;
+            }
+            else if (load > (FRAME_TICKS * DITHER_OFF_LOAD / 100))
+            {
+                sDither = false;
+            }
+            ditherRender = (sDither && (sRenderLevel < GOV_NO_DITHER) && (interval == 1));
+            setDither(ditherRender);
+#ifdef SAUCER_DEBUG
+            debugRenderTime(renderTicks);
+            debugDitherTime(sDitherTicks, dither);
+#endif
+
+            steps = 0;
+        }
+
+#ifdef UART_ENABLED
+        // serial commands
+        switch (uartGetc())
+        {
+#ifdef TRACE_RECORDER
+            case 'd': traceDump(); break;
+#endif
+#ifdef SAUCER_DEBUG
+            case 's': debugStats(); break;
+#endif
+#ifdef FRAME_MIRROR
+            case 'm': mirrorStats(); break;
+#endif
+            case 'u': usageDump(); break;
+            default: break;
+        }
+#endif
+
+        // wait for the next frame, don't try to catch up after an overrun
+        frameStart += FRAME_TICKS;
+        if ((int16_t)(timerTicks() - frameStart) > 0)
+        {
+            frameStart = timerTicks();
+        }
+        lampEvents = lampPassthrough() ? passthrough(frameStart, &ledState) : 0;
+        timerWaitUntil(frameStart);
     }
     return 0;
 }
@@ -123,21 +414,53 @@ int main(void)
 // LED data interrupt
 ISR(INT0_vect)
 {
+    // a pause in the lamp clock starts a new frame
+    uint16_t now = TCNT1;
+    if ((uint16_t)(now - sLampClockTime) > LAMP_FRAME_GAP)
+    {
+        sLampBits = 0;
+    }
+    sLampClockTime = now;
+
     // shift new value into LED status
     svLEDState <<= 1;
     *((uint8_t*)&svLEDState) |= ((PIND >> 4) & 0x01);
+
+    // report completed frames if they changed
+    sLampBits++;
+    if (sLampBits == 16)
+    {
+        sLampBits = 0;
+        // a frame which didn't fit into the queue is reported again with the
+        // next one, even if unchanged
+        if ((svLEDState != sLampFrame) && eventPush(EV_LAMPS, svLEDState))
+        {
+            sLampFrame = svLEDState;
+        }
+    }
 }
 
 //------------------------------------------------------------------------------
 // flasher interrupt
 ISR(INT1_vect)
 {
-    svFlashState = true;
+    eventPush(EV_FLASH, 0);
 }
 
 //------------------------------------------------------------------------------
 // shaker interrupt
 ISR(PCINT2_vect)
 {
-    svShakerState = true;
+    eventPush(EV_SHAKER, (PIND >> 7) & 0x01);
+}
+
+//------------------------------------------------------------------------------
+// DIP switch interrupt
+ISR(PCINT1_vect)
+{
+    // the main loop reads the switches itself if the change got lost
+    if (!eventPush(EV_CONFIG, (~PINC & 0x0f)))
+    {
+        svConfigLost = true;
+    }
 }
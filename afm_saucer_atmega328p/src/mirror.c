@@ -0,0 +1,174 @@
+/***********************************************************************
+ *    _   _   _             _     __                                           
+ *   /_\ | |_| |_ __ _  ___| | __/ _|_ __ ___  _ __ ___   /\/\   __ _ _ __ ___ 
+ *  //_\\| __| __/ _` |/ __| |/ / |_| '__/ _ \| '_ ` _ \ /    \ / _` | '__/ __|
+ * /  _  \ |_| || (_| | (__|   <|  _| | | (_) | | | | | / /\/\ \ (_| | |  \__ \
+ * \_/ \_/\__|\__\__,_|\___|_|\_\_| |_|  \___/|_| |_| |_\/    \/\__,_|_|  |___/
+ *
+ *                              ____ ____ ___ 
+ *                              |--< |__, |==]
+ *
+ *                      ____ ____ _  _ ____ ____ ____
+ *                      ==== |--| |__| |___ |=== |--<
+ *
+ *  Copyright (c) 2022 bitfield labs
+ * 
+ ***********************************************************************
+ *  This file is part of the Attack from Mars! RGB saucer project:
+ *  https://github.com/bitfieldlabs/afm_saucer
+ *
+ *  The AfM RGB saucer is free software: you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public License as
+ *  published by the Free Software Foundation, either version 3 of the
+ *  License, or (at your option) any later version.
+ *
+ *  AfM RGB saucer is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with afterglow.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ ***********************************************************************/
+
+#ifdef FRAME_MIRROR
+
+#include <stdbool.h>
+#include "mirror.h"
+#include "modes.h"
+#include "uart.h"
+#include "timer.h"
+
+
+// Packet format, all rendered frames while there is space in the transmit
+// buffer:
+//
+//   0xfe                   sync
+//   seq                    packet sequence number
+//   flags                  saucer mode, bit 7 set for a key frame with all pixels
+//   lamps lo, hi           raw lamp state (active low)
+//   time lo, hi            frame time [64us], wraps every 4.2s
+//   { ix, r, g, b } ...    changed pixels, ix 0-15 saucer LEDs, 16-19 flashers
+//   0xff                   end
+//   sum                    8 bit sum of all bytes after sync
+
+
+//------------------------------------------------------------------------------
+// definitions
+
+#define MIRROR_SYNC 0xfe
+#define MIRROR_END 0xff
+#define MIRROR_KEY 0x80                     // key frame flag
+#define MIRROR_TIME_SHIFT 4                 // time unit is 2^MIRROR_TIME_SHIFT timer ticks (64us)
+#define MIRROR_KEY_FRAMES 50                // every pixel is sent at least this often [frames]
+#define MIRROR_MAX_PACKET (8 + (NUM_PIXELS * 4) + 2)   // largest packet [bytes]
+
+
+//------------------------------------------------------------------------------
+// global variables
+
+static uint8_t sPrev[NUM_PIXELS][3];           // pixels as last sent to the host
+static bool sActive = false;                   // a packet is being put
+static bool sKey = false;                      // current packet is a key frame
+static uint8_t sKeyCountdown = 0;              // packets until the next key frame
+static uint8_t sPixelIx = 0;                   // next pixel of the frame
+static uint8_t sSeq = 0;                       // packet sequence number
+static uint8_t sSum = 0;                       // packet checksum
+static uint32_t sDropped = 0;                  // frames not sent for lack of buffer space
+static uint16_t sLastTicks = 0;                // timer at the previous frame [ticks]
+static uint32_t sTime = 0;                     // frame time extended beyond the timer wrap [ticks]
+
+
+//------------------------------------------------------------------------------
+static void put(uint8_t v)
+{
+    sSum += v;
+    uartTxPut(v);
+}
+
+//------------------------------------------------------------------------------
+void mirrorBegin(uint16_t lamps, uint8_t mode)
+{
+    // the timer wraps after 262ms, frames are always rendered more often
+    uint16_t now = timerTicks();
+    sTime += (uint16_t)(now - sLastTicks);
+    sLastTicks = now;
+
+    // Never wait for the serial port. A frame which doesn't fit is dropped
+    // and the next one is a key frame, as the host missed changes.
+    sActive = (uartTxFree() >= MIRROR_MAX_PACKET);
+    if (!sActive)
+    {
+        sDropped++;
+        sKeyCountdown = 0;
+        return;
+    }
+    sKey = (sKeyCountdown == 0);
+    sKeyCountdown = sKey ? (MIRROR_KEY_FRAMES - 1) : (sKeyCountdown - 1);
+
+    uint16_t t = (uint16_t)(sTime >> MIRROR_TIME_SHIFT);
+    sPixelIx = 0;
+    sSum = 0;
+    uartTxPut(MIRROR_SYNC);
+    put(sSeq++);
+    put(mode | (sKey ? MIRROR_KEY : 0));
+    put(lamps & 0xff);
+    put(lamps >> 8);
+    put(t & 0xff);
+    put(t >> 8);
+}
+
+//------------------------------------------------------------------------------
+void mirrorPixel(uint8_t r, uint8_t g, uint8_t b)
+{
+    // called for every pixel before it is sent, also by refreshes outside of
+    // a packet
+    if (!sActive || (sPixelIx >= NUM_PIXELS))
+    {
+        return;
+    }
+    uint8_t *p = sPrev[sPixelIx];
+    if (sKey || (p[0] != r) || (p[1] != g) || (p[2] != b))
+    {
+        put(sPixelIx);
+        put(r);
+        put(g);
+        put(b);
+        p[0] = r;
+        p[1] = g;
+        p[2] = b;
+    }
+    sPixelIx++;
+}
+
+//------------------------------------------------------------------------------
+void mirrorEnd()
+{
+    if (sActive)
+    {
+        put(MIRROR_END);
+        uartTxPut(sSum);
+        uartTxCommit();
+        sActive = false;
+    }
+}
+
+//------------------------------------------------------------------------------
+uint32_t mirrorDropped()
+{
+    return sDropped;
+}
+
+//------------------------------------------------------------------------------
+void mirrorStats()
+{
+    // "<name> <value>" lines like the debug statistics, shown by the viewer
+    // between the packets
+    uartPuts("MIRROR\n");
+    uartPuts("mirror_dropped ");
+    uartPutDec(sDropped);
+    uartPuts("\nEND\n");
+}
+
+#endif
@@ -33,24 +33,59 @@
  ***********************************************************************/
 
 #include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
 #include <avr/io.h>
+#include <avr/pgmspace.h>
+#include "options.h"
 #include "modes.h"
+#include "layers.h"
 #include "led.h"
 #include "utils.h"
 #include "patterns.h"
+#include "particles.h"
+#include "chase.h"
+#include "governor.h"
+#include "timer.h"
+#ifdef FRAME_MIRROR
+#include "mirror.h"
+#endif
 
 
 //------------------------------------------------------------------------------
 // definitions
 
-#define NUM_LEDS 16
-#define NUM_FLASHER 4
-
+#define FRAME_TICKS (20000 / TIMER_TICK_US)   // base frame interval, LED_UPDATE_INT in main.c [ticks]
 #define FLASH_DURATION 4                    // flasher duration [frames]
 #define SHAKER_DURATION 64                  // shaker duration [frames]
+#define SPARKLE_CHANCE 2                    // one in SPARKLE_CHANCE frames spawns a sparkle while shaking
+#define FLASH_PARTICLE_HUE 85               // hue of the particles bursting on a flash
 
 #define MODE_IND_ACCUM_STEPS 64
 
+#define POWER_BUDGET_MA 600                 // maximum estimated LED current [mA]
+#define POWER_CHANNEL_MA 20                 // current of one colour channel at full brightness [mA]
+#define POWER_IDLE_MA 1                     // current of one dark LED [mA]
+#define POWER_AVG_SHIFT 6                   // average current over 2^POWER_AVG_SHIFT frames
+#define POWER_IDLE_TOTAL_MA (NUM_PIXELS * POWER_IDLE_MA)
+#define POWER_BUDGET_SUM ((uint32_t)(POWER_BUDGET_MA - POWER_IDLE_TOTAL_MA) * 255 / POWER_CHANNEL_MA)  // budget as sum of channel values
+
+#define XFADE_FRAMES 16                     // duration of mode and pattern crossfades [frames]
+
+#define RATE_DIV_MAX 4                      // lowest frame rate as divider of the base rate   ** CHOOSE A POWER OF 2 **
+#define RATE_QUIET_FRAMES 8                 // quiet rendered frames before halving the frame rate
+#define ACTIVITY_MIN_DIFF 2                 // channel change per base frame counting as activity, above the dithering
+
+#define FLASH_COLOR_R 100                   // flasher colour
+#define FLASH_COLOR_G 255
+#define FLASH_COLOR_B 100
+
+#define WARM_STATE_MAGIC 0xa5              // checksum start value of the warm restart state
+
+#define ERROR_COLOR_R 255                   // colour shown on all LEDs after a fatal error
+#define ERROR_COLOR_G 0
+#define ERROR_COLOR_B 255
+
 
 //------------------------------------------------------------------------------
 // global variables
@@ -62,20 +97,73 @@ static SAUCER_MODES_t sMode = SM_NUM;          // auto detected saucer mode
 static uint8_t sModeIndicators[SM_NUM]= {0};   // accumulated saucer mode indicators
 static LED_MODE_t sFGMode;                     // foreground color mode
 static LED_MODE_t sBGMode;                     // background color mode
-static LED_MODE_VALUES_t sFGModeValues[NUM_LEDS];        // current foreground mode values
-static LED_MODE_VALUES_t sBGModeValues[NUM_LEDS];        // current background mode values
-static uint8_t sLEDActive[NUM_LEDS] = { 0 };   // LED active status (afterglow counter)
-static uint8_t sBGAnimCount = 0;               // background animation countdown
+static uint8_t sLEDActive[NUM_LEDS] = { 0 };   // LED active status (afterglow counter or bulb brightness)
+static uint16_t sAGScale = 0;                  // afterglow step to blend factor, 256/afterglow
+static uint16_t sLEDStateApplied = 0;          // lamp state last applied to the LED active status
+static uint16_t sLEDStepped = 0;               // LEDs which took the step of the coming frame at a lamp edge
 static uint8_t sCfg = 0;                       // pattern configuration id
 static uint8_t sCfgSel = 0;                    // selected pattern configuration id
 static uint32_t sFrameCnt = 0;                 // frame counter
 static uint16_t sBootupJingleCountdown = 200;           // bootup jingle countdown
+static bool sError = false;                    // fatal error latched
+static bool sDither = false;                   // temporal dithering active
+static uint8_t sDitherAccBG[NUM_LEDS / 2] = { 0 };   // background dithering error accumulators (value fraction), a nibble per LED
+static uint8_t sDitherAccFG[NUM_LEDS / 2] = { 0 };   // foreground dithering error accumulators (value fraction), a nibble per LED
+static uint16_t sPowerPeak = 0;                // peak estimated LED current [mA]
+static uint32_t sPowerAvg = 0;                 // average estimated LED current [mA * 2^POWER_AVG_SHIFT]
+static uint32_t sPowerLimited = 0;             // number of frames scaled down to the budget
+#ifdef FEATURE_XFADE
+static uint8_t sXFadeFrame[NUM_LEDS][3];       // saucer LED colours of the last frame, crossfade start
+#endif
+static uint8_t sXFadeCount = 0;                // remaining crossfade frames
+static uint16_t sXFadeTicksMax = 0;            // longest crossfade blending [ticks]
+static uint32_t sAnimFrame = 0;                // frames since the mode was applied
+static uint8_t sBGRot = 0;                     // background rotation [LEDs]
+static uint8_t sActivityDiff = ACTIVITY_MIN_DIFF;   // channel change counting as activity in the current render
+static uint8_t sChanged = 0;                   // saucer LEDs changed since the last frame interval decision
+static uint8_t sRateDiv = 1;                   // current frame rate divider
+static uint8_t sQuietFrames = 0;               // rendered frames without activity
+static uint32_t sRenderedFrames = 0;           // number of rendered frames
+static uint8_t sRenderLevel = GOV_FULL;        // render degradation level (GOV_LEVEL_t)
+#ifdef FEATURE_GOVERNOR
+static uint8_t sBGCache[NUM_LEDS][3];          // last computed background colours
+#endif
+static uint16_t sBGCacheValid = 0;             // LEDs with a valid background colour, one bit each
+
+// phase accumulator of one layer, all LEDs follow from the first one
+typedef struct OSCILLATOR_s
+{
+    uint32_t incH;      // hue phase increment [1/256 per frame]
+    uint32_t incV;      // value phase increment [1/256 per frame]
+    uint16_t ofsH;      // hue phase offset between neighbour LEDs
+    uint16_t ofsV;      // value phase offset between neighbour LEDs
+    uint16_t phaseH;    // current hue phase of the first LED
+    uint16_t phaseV;    // current value phase of the first LED
+} OSCILLATOR_t;
+static OSCILLATOR_t sFGOsc;                    // foreground oscillator
+static OSCILLATOR_t sBGOsc;                    // background oscillator
+
+// state surviving a watchdog or brown-out reset
+typedef struct WARM_STATE_s
+{
+    uint8_t mode;                       // saucer mode
+    uint8_t cfg;                        // pattern configuration id
+    uint8_t cfgSel;                     // selected pattern configuration id
+    uint8_t modeIndicators[SM_NUM];     // accumulated saucer mode indicators
+    uint32_t frameCnt;                  // frame counter
+    uint32_t animFrame;                 // frames since the mode was applied
+    uint8_t checksum;                   // checksum over all fields above
+} WARM_STATE_t;
+static WARM_STATE_t sWarmState __attribute__ ((section (".noinit")));
 
 
 //------------------------------------------------------------------------------
 // declarations
 
 void setMode(SAUCER_MODES_t mode);
+void applyMode(SAUCER_MODES_t mode);
+void saveWarmState();
+void renderLEDs(bool frame);
 
 
 //------------------------------------------------------------------------------
@@ -160,233 +248,733 @@ void updateLEDState(uint16_t newState)
 }
 
 //------------------------------------------------------------------------------
-void triggerFlasher()
+uint8_t getMode()
 {
-    sFlashState = FLASH_DURATION;
+    return sMode;
 }
 
 //------------------------------------------------------------------------------
-void triggerShaker()
+void setConfig(uint8_t cfg)
 {
-    sShakerState = SHAKER_DURATION;
+    if (cfg != sCfg)
+    {
+        sCfg = cfg;
+        setMode(sMode);
+    }
 }
 
+//------------------------------------------------------------------------------
+uint8_t fxHue()
+{
+    // the effects take the foreground start hue
+    return (sFGMode.startH / VSCALE);
+}
 
 //------------------------------------------------------------------------------
-void getColor(uint8_t pos, uint8_t agStep, uint8_t *r, uint8_t *g, uint8_t *b)
+uint16_t eventAge(uint16_t time)
 {
-    if (agStep)
+    // time since an input event [1/256 frames]
+    uint16_t t = (timerTicks() - time);
+    return (uint16_t)(((uint32_t)t << 8) / FRAME_TICKS);
+}
+
+//------------------------------------------------------------------------------
+uint8_t ageDuration(uint8_t duration, uint16_t age)
+{
+    // frames left of an effect started age ago, at least one
+    uint8_t frames = (age >> 8);
+    return (frames < duration) ? (duration - frames) : 1;
+}
+
+//------------------------------------------------------------------------------
+void triggerFlasher(uint16_t time)
+{
+    // the effects start from the time of the flasher edge
+    uint16_t age = eventAge(time);
+    sFlashState = ageDuration(FLASH_DURATION, age);
+    if (sFGMode.particles)
     {
-        if (agStep >= sFGMode.afterglow)
-        {
-            // full foreground color
-            LED_MODE_VALUES_t *mv = &sFGModeValues[pos];
+        particlesBurst(FLASH_PARTICLE_HUE);
+    }
+    if (sFGMode.effects & FX_SHOCKWAVE)
+    {
+        fxShockwave(fxHue(), age);
+    }
+}
 
-            // randomly add sparkles when shaken (expect original configuration 15)
-            if ((sShakerState && ((rand() % 10) == 0)) && (sCfg != 15))
-            {
-                mv->currShakerH = (((uint8_t)rand()) << 4);
-                mv->currV = (255*VSCALE);
-            }
-            else if (sShakerState == 0)
-            {
-                mv->currShakerH = 0;
-            }
+//------------------------------------------------------------------------------
+void triggerShaker(uint16_t time)
+{
+    sShakerState = ageDuration(SHAKER_DURATION, eventAge(time));
+}
 
-            uint8_t h = (mv->currShakerH > 0) ? (mv->currShakerH>>4) : (mv->currH>>4);
-            hsv2rgb(h, 255, (mv->currV>>4), r, g, b);
-        }
-        else
+
+//------------------------------------------------------------------------------
+void setDither(bool on)
+{
+    sDither = on;
+}
+
+//------------------------------------------------------------------------------
+void setRenderLevel(uint8_t level)
+{
+    sRenderLevel = level;
+}
+
+//------------------------------------------------------------------------------
+uint8_t ditherV(uint8_t *accs, uint8_t pos, uint16_t v)
+{
+    // Without dithering the VSCALE fraction is simply dropped. With dithering
+    // it is accumulated per LED and carried into the next refresh, so the
+    // average over successive refreshes matches the precise value. Only the
+    // value is dithered: the layers are fully saturated, so every channel
+    // hsv2rgb() derives from it scales with it, and a per channel error would
+    // need more than the 8 bit channels it returns. The background and the
+    // foreground keep their own accumulators, as an LED blends both. Two LEDs
+    // share an accumulator byte, VSCALE leaves 4 bits of fraction each.
+    if (!sDither)
+    {
+        return (v >> 4);
+    }
+    uint8_t *acc = &accs[pos >> 1];
+    uint8_t shift = (pos & 1) ? 4 : 0;
+    uint16_t d = v + ((*acc >> shift) & (VSCALE - 1));
+    *acc = (*acc & ~((VSCALE - 1) << shift)) | ((d & (VSCALE - 1)) << shift);
+    d >>= 4;
+    return (d > 255) ? 255 : d;
+}
+
+//------------------------------------------------------------------------------
+uint16_t oscValue(uint8_t wave, uint16_t phase, uint16_t start, uint16_t end)
+{
+    // map the wave sample onto the start..end range
+    if (end <= start)
+    {
+        return start;
+    }
+    return start + (uint16_t)(((uint32_t)(end - start) * waveSample(wave, phase)) >> 16);
+}
+
+//------------------------------------------------------------------------------
+void layerColor(const LED_MODE_t *ledMode, const OSCILLATOR_t *osc, uint8_t ix, uint8_t *h, uint16_t *v)
+{
+    // hue in 8 bit, value still in VSCALE units for the dithering
+    *h = (oscValue(WAVE_TRIANGLE, osc->phaseH + ix * osc->ofsH, ledMode->startH, ledMode->endH) >> 4);
+    *v = oscValue(ledMode->wave, osc->phaseV + ix * osc->ofsV, ledMode->startV, ledMode->endV);
+}
+
+//------------------------------------------------------------------------------
+bool bgVisible(const FRAME_t *f)
+{
+    if (clipActive())
+    {
+        return true;
+    }
+    if ((sBGMode.startV == 0) && (sBGMode.endV == 0))
+    {
+        // dark background
+        return false;
+    }
+    // blinking, off
+    return !((sBGMode.blinkInt) && ((sFrameCnt >> sBGMode.blinkInt) % 2));
+}
+
+//------------------------------------------------------------------------------
+void renderBackground(FRAME_t *f, uint8_t blend)
+{
+    if (clipActive())
+    {
+        // precomputed clip, the flashers stay with the flasher layer
+        for (uint8_t i=0; i<NUM_LEDS; i++)
         {
-            // afterglow -> mix foreground and background color
-            uint8_t rf, gf, bf, rb, gb, bb;
-            const LED_MODE_VALUES_t *mv = &sFGModeValues[pos];
-            hsv2rgb((mv->currH>>4), 255, (mv->currV>>4), &rf, &gf, &bf);
-            mv = &sBGModeValues[pos];
-            hsv2rgb((mv->currH>>4), 255, (mv->currV>>4), &rb, &gb, &bb);
-
-            uint8_t ratio = (agStep * (256/sFGMode.afterglow));
-            *r = blend8(rb, rf, ratio);
-            *g = blend8(gb, gf, ratio);
-            *b = blend8(bb, bf, ratio);
+            uint8_t r, g, b;
+            clipPixel(i, &r, &g, &b);
+            layerPixel(f, i, r, g, b, blend, 255);
         }
+        return;
     }
-    else
+    // the governor may ask to reuse the colours of a previous frame
+    bool reuse = (sRenderLevel >= GOV_BG_REUSE);
+    for (uint8_t i=0; i<NUM_LEDS; i++)
     {
-        // full background color
-        const LED_MODE_VALUES_t *mv = &sBGModeValues[pos];
+        uint8_t ag = f->ag[i];
+        if (ag == AG_FULL)
+        {
+            // hidden below the full foreground color
+            continue;
+        }
+#ifdef FEATURE_GOVERNOR
+        uint8_t *c = sBGCache[i];
+#else
+        uint8_t c[3];
+#endif
+        if (!reuse || !(sBGCacheValid & (1 << i)))
+        {
+            uint8_t h;
+            uint16_t v;
+            layerColor(&sBGMode, &sBGOsc, ((i + sBGRot) & (NUM_LEDS - 1)), &h, &v);
+            hsv2rgb(h, 255, (ag ? (v>>4) : ditherV(sDitherAccBG, i, v)), &c[0], &c[1], &c[2]);
+            sBGCacheValid |= (1 << i);
+        }
+        layerPixel(f, i, c[0], c[1], c[2], blend, 255);
+    }
+}
 
-        // blinking
-        if ((sBGMode.blinkInt) && ((sFrameCnt >> sBGMode.blinkInt) % 2))
+//------------------------------------------------------------------------------
+bool fgVisible(const FRAME_t *f)
+{
+    return (f->lit != 0);
+}
+
+//------------------------------------------------------------------------------
+void renderForeground(FRAME_t *f, uint8_t blend)
+{
+    for (uint8_t i=0; i<NUM_LEDS; i++)
+    {
+        uint8_t ag = f->ag[i];
+        if (!ag)
+        {
+            continue;
+        }
+        uint8_t h, r, g, b;
+        uint16_t v;
+        layerColor(&sFGMode, &sFGOsc, i, &h, &v);
+        if (ag == AG_FULL)
         {
-            // off
-            *r = *g = *b = 0;
+            // full foreground color
+            hsv2rgb(h, 255, ditherV(sDitherAccFG, i, v), &r, &g, &b);
+            layerPixel(f, i, r, g, b, blend, 255);
         }
         else
         {
-            // on
-            hsv2rgb((mv->currH>>4), 255, (mv->currV>>4), r, g, b);
+            // afterglow -> mix over the background color
+            hsv2rgb(h, 255, (v>>4), &r, &g, &b);
+            layerPixel(f, i, r, g, b, blend, ag);
         }
     }
 }
 
 //------------------------------------------------------------------------------
-void nextValue(uint16_t *v, int16_t *inc, int16_t min, int16_t max)
+bool particlesVisible(const FRAME_t *f)
+{
+    return (particlesActive() && (sRenderLevel < GOV_NO_SPARKLES));
+}
+
+//------------------------------------------------------------------------------
+bool fxVisible(const FRAME_t *f)
+{
+    return fxActive();
+}
+
+//------------------------------------------------------------------------------
+bool flasherVisible(const FRAME_t *f)
+{
+    return (sFlashState != 0);
+}
+
+//------------------------------------------------------------------------------
+void renderFlasher(FRAME_t *f, uint8_t blend)
+{
+    for (uint8_t i=NUM_LEDS; i<NUM_PIXELS; i++)
+    {
+        layerPixel(f, i, FLASH_COLOR_R, FLASH_COLOR_G, FLASH_COLOR_B, blend, 255);
+    }
+}
+
+//------------------------------------------------------------------------------
+uint32_t phaseInc(int16_t speed, uint16_t start, uint16_t end)
+{
+    // One phase cycle of 65536 covers the range up and down again, i.e.
+    // 2*range steps of speed. The increment keeps 8 fractional bits.
+    if (end <= start)
+    {
+        return 0;
+    }
+    if (speed > SPEED_MAX)
+    {
+        speed = SPEED_MAX;
+    }
+    else if (speed < -SPEED_MAX)
+    {
+        speed = -SPEED_MAX;
+    }
+    return (uint32_t)(((int32_t)speed * ((int32_t)1 << 23)) / (end - start));
+}
+
+//------------------------------------------------------------------------------
+uint16_t phaseOfs(int16_t ofs, uint16_t start, uint16_t end)
 {
-    int16_t nv = ((int16_t)*v + *inc);
-    if (nv > max)
+    // phase distance equivalent to a value offset of ofs
+    if (end <= start)
     {
-        nv = max;
-        *inc = -(*inc);
+        return 0;
     }
-    else if (nv < min)
+    return (uint16_t)(((int32_t)ofs << 15) / (end - start));
+}
+
+//------------------------------------------------------------------------------
+void initOscillator(const LED_MODE_t *ledMode, OSCILLATOR_t *osc)
+{
+    osc->incH = phaseInc(ledMode->speedH, ledMode->startH, ledMode->endH);
+    osc->incV = phaseInc(ledMode->speedV, ledMode->startV, ledMode->endV);
+    osc->ofsH = phaseOfs(ledMode->ofsH, ledMode->startH, ledMode->endH);
+    osc->ofsV = phaseOfs(ledMode->ofsV, ledMode->startV, ledMode->endV);
+    osc->phaseH = 0;
+    osc->phaseV = 0;
+}
+
+//------------------------------------------------------------------------------
+void advanceOscillator(OSCILLATOR_t *osc)
+{
+    // the phase is a function of the frame count only, nothing accumulates
+    osc->phaseH = (uint16_t)((sAnimFrame * osc->incH) >> 8);
+    osc->phaseV = (uint16_t)((sAnimFrame * osc->incV) >> 8);
+}
+
+//------------------------------------------------------------------------------
+void latchError()
+{
+    sError = true;
+}
+
+//------------------------------------------------------------------------------
+static inline uint8_t bulbHeat(uint8_t v, uint8_t rise)
+{
+    // Filament heating up: the brightness closes 1/2^rise of the distance to
+    // full every frame, at least by one step.
+    uint8_t d = ((uint8_t)(AG_FULL - v) >> rise);
+    if (d)
     {
-        nv = min;
-        *inc = -(*inc);
+        return (v + d);
     }
-    *v = (uint16_t)nv;
+    return (v < AG_FULL) ? (v + 1) : AG_FULL;
 }
 
 //------------------------------------------------------------------------------
-void advanceMode(const LED_MODE_t *ledMode, LED_MODE_VALUES_t *ledModeValues)
+static inline uint8_t bulbCool(uint8_t v, uint8_t decay)
 {
-    // advance for all LEDs
+    // filament cooling down: 1/2^decay of the brightness is lost every frame,
+    // at least one step so it ends at 0
+    uint8_t d = (v >> decay);
+    return (v - (d ? d : 1));
+}
+
+//------------------------------------------------------------------------------
+void updateLEDActive(uint16_t mask)
+{
+    // one afterglow or bulb step of the LEDs in mask
+    uint16_t state = sLEDState;
+    uint8_t bulb = sFGMode.bulb;
     for (uint8_t i=0; i<NUM_LEDS; i++)
     {
-        nextValue(&ledModeValues->currH, &ledModeValues->currSpeedH, ledMode->startH, ledMode->endH);
-        nextValue(&ledModeValues->currV, &ledModeValues->currSpeedV, ledMode->startV, ledMode->endV);
-        ledModeValues++;
+        if (mask & 0x01)
+        {
+            if (state & 0x01)
+            {
+                if (!sLEDActive[i] && (sFGMode.effects & FX_RIPPLE))
+                {
+                    // lamp turning on
+                    fxRipple(i, fxHue());
+                }
+                sLEDActive[i] = bulb ? bulbHeat(sLEDActive[i], (bulb >> 4)) : sFGMode.afterglow;
+            }
+            else if (sLEDActive[i])
+            {
+                sLEDActive[i] = bulb ? bulbCool(sLEDActive[i], (bulb & 0x0f)) : (sLEDActive[i] - 1);
+            }
+        }
+        state >>= 1;
+        mask >>= 1;
+    }
+    sLEDStateApplied = sLEDState;
+}
+
+//------------------------------------------------------------------------------
+void advanceFrame()
+{
+    // advance the mode
+    sAnimFrame++;
+    advanceOscillator(&sFGOsc);
+    advanceOscillator(&sBGOsc);
+    if (sBGMode.animSpeed)
+    {
+        // rotate the background LEDs by one every animSpeed frames
+        uint8_t steps = (uint8_t)(sAnimFrame / sBGMode.animSpeed);
+        sBGRot = sBGMode.animDir ? steps : -steps;
     }
+    clipAdvance();
+
+    // randomly add sparkles when shaken
+    if (sShakerState && sFGMode.particles && (sRenderLevel < GOV_NO_SPARKLES) &&
+        ((rand() % SPARKLE_CHANCE) == 0))
+    {
+        particlesSparkle();
+    }
+    particlesAdvance();
+    fxAdvance();
+
+    // follow the lamp chases to draw their leading edges
+    if (sMode == SM_ATTACK)
+    {
+        chaseUpdate(sLEDState);
+    }
+
+    // activate the LEDs for the afterglow duration, or heat and cool the
+    // emulated bulbs, except for those already stepped at a lamp edge
+    updateLEDActive(~sLEDStepped);
+    sLEDStepped = 0;
 }
 
 //------------------------------------------------------------------------------
-void rotateBGLEDs(bool dir)
+void endFrame()
 {
-    if (dir)
+    if (sFlashState)
     {
-        // rotate clockwise
-        LED_MODE_VALUES_t tmp = sBGModeValues[0];
-        for (uint8_t i=0; i<(NUM_LEDS-1); i++)
+        sFlashState--;
+    }
+    if (sShakerState)
+    {
+        sShakerState--;
+    }
+    if (sXFadeCount)
+    {
+        sXFadeCount--;
+    }
+
+    sFrameCnt++;
+}
+
+//------------------------------------------------------------------------------
+void updateLEDs(uint8_t steps)
+{
+    // nothing but the error colour after a fatal error
+    if (sError)
+    {
+#ifdef FRAME_MIRROR
+        for (uint8_t i=0; i<(NUM_LEDS+NUM_FLASHER); i++)
         {
-            sBGModeValues[i] = sBGModeValues[i+1];
+            mirrorPixel(ERROR_COLOR_R, ERROR_COLOR_G, ERROR_COLOR_B);
         }
-        sBGModeValues[NUM_LEDS-1] = tmp;
+#endif
+        for (uint8_t i=0; i<(NUM_LEDS+NUM_FLASHER); i++)
+        {
+            sendPixel(ERROR_COLOR_R, ERROR_COLOR_G, ERROR_COLOR_B, (i < NUM_LEDS));
+        }
+        return;
     }
-    else
+
+    // advance everything by all base frames since the last render, so the
+    // animation speed doesn't depend on the frame rate
+    for (uint8_t n=0; n<steps; n++)
     {
-        // rotate counterclockwise
-        LED_MODE_VALUES_t tmp = sBGModeValues[NUM_LEDS-1];
-        for (uint8_t i=NUM_LEDS-1; i>0; i--)
+        if (n)
         {
-            sBGModeValues[i] = sBGModeValues[i-1];
+            endFrame();
         }
-        sBGModeValues[0] = tmp;
+        advanceFrame();
     }
 
-    // reset the animation counter
-    sBGAnimCount = sBGMode.animSpeed;
+    // activity is measured per base frame
+    sActivityDiff = (steps * ACTIVITY_MIN_DIFF);
+    renderLEDs(true);
+    sRenderedFrames++;
+    endFrame();
+
+    saveWarmState();
 }
 
 //------------------------------------------------------------------------------
-void updateLEDs()
+bool lampPassthrough()
 {
-    // advance the mode
-    advanceMode(&sFGMode, &sFGModeValues[0]);
-    advanceMode(&sBGMode, &sBGModeValues[0]);
-    if (sBGMode.animSpeed)
+    return sFGMode.passthrough;
+}
+
+//------------------------------------------------------------------------------
+void showLamps(uint16_t newState)
+{
+    // A lamp frame between two animation frames. The LEDs whose lamps changed
+    // take their step of the coming frame right away, which the frame then
+    // skips, so every LED keeps to one afterglow or bulb step per frame
+    // however often its lamp toggles. The animation and the mode detection
+    // keep to the frame timer.
+    sLEDState = ~newState;
+    uint16_t edges = ((sLEDState ^ sLEDStateApplied) & ~sLEDStepped);
+    updateLEDActive(edges);
+    sLEDStepped |= edges;
+    renderLEDs(false);
+}
+
+//------------------------------------------------------------------------------
+uint8_t frameInterval(uint8_t events)
+{
+    // Bursts, attack chases and anything visibly moving run at the base rate.
+    // A quiet scene halves the rate every RATE_QUIET_FRAMES rendered frames,
+    // down to 1/RATE_DIV_MAX. Returns the number of base frames until the
+    // next render.
+    bool busy = (events || sChanged || sXFadeCount || sFlashState || sShakerState ||
+                 (sMode == SM_ATTACK) || particlesActive() || fxActive());
+    sChanged = 0;
+    if (busy)
+    {
+        sRateDiv = 1;
+        sQuietFrames = 0;
+    }
+    else if (sRateDiv < RATE_DIV_MAX)
     {
-        sBGAnimCount--;
-        if (sBGAnimCount == 0)
+        sQuietFrames++;
+        if (sQuietFrames >= RATE_QUIET_FRAMES)
         {
-            // rotate the background LEDs
-            rotateBGLEDs(sBGMode.animDir);
+            sRateDiv <<= 1;
+            sQuietFrames = 0;
         }
     }
+    return sRateDiv;
+}
 
-    uint8_t r[NUM_LEDS];
-    uint8_t g[NUM_LEDS];
-    uint8_t b[NUM_LEDS];
+//------------------------------------------------------------------------------
+void getRateStats(uint32_t *frames, uint32_t *rendered)
+{
+    *frames = sFrameCnt;
+    *rendered = sRenderedFrames;
+}
 
-    // prepare all LEDs
-    uint16_t state = sLEDState;
-    for (uint8_t i=0; i<NUM_LEDS; i++)
+//------------------------------------------------------------------------------
+uint8_t powerLimit(uint16_t sum, bool frame)
+{
+    // Estimate the current from the sum of all channel values. The statistics
+    // count animation frames only, refreshes and lamp passthrough renders in
+    // between would weigh the average towards the busy scenes.
+    if (frame)
     {
-        // activate the LED for the afterglow duration
-        if (state & 0x01)
+        uint16_t mA = (uint16_t)(((uint32_t)sum * POWER_CHANNEL_MA) / 255) + POWER_IDLE_TOTAL_MA;
+        if (mA > sPowerPeak)
         {
-            sLEDActive[i] = sFGMode.afterglow;
+            sPowerPeak = mA;
         }
-        else
+        sPowerAvg = sPowerAvg - (sPowerAvg >> POWER_AVG_SHIFT) + mA;
+    }
+
+    // scale factor bringing the frame down to the budget, 0 if within budget
+    if (sum <= POWER_BUDGET_SUM)
+    {
+        return 0;
+    }
+    if (frame)
+    {
+        sPowerLimited++;
+    }
+    return (uint8_t)((POWER_BUDGET_SUM * 256) / sum);
+}
+
+//------------------------------------------------------------------------------
+static inline bool colorMoved(uint8_t from, uint8_t to)
+{
+    return (((from > to) ? (from - to) : (to - from)) > sActivityDiff);
+}
+
+//------------------------------------------------------------------------------
+void crossfade(FRAME_t *f)
+{
+    // Each frame moves 1/remaining of the way from the last sent colour to the
+    // new one. For a steady target that is a linear fade, and a mode switch in
+    // the middle of a fade continues from what is currently shown. Outside of
+    // fades the frame is only kept as the start of the next one, and the LEDs
+    // which changed noticeably are counted for the frame rate.
+#ifdef FEATURE_XFADE
+    if (sXFadeCount)
+    {
+        uint16_t t = timerTicks();
+        uint8_t ratio = (sXFadeCount > 1) ? (256 / sXFadeCount) : 255;
+        for (uint8_t i=0; i<NUM_LEDS; i++)
+        {
+            uint8_t *o = sXFadeFrame[i];
+            o[0] = blend8(o[0], f->r[i], ratio);
+            o[1] = blend8(o[1], f->g[i], ratio);
+            o[2] = blend8(o[2], f->b[i], ratio);
+            frameChannel(f, &f->r[i], o[0]);
+            frameChannel(f, &f->g[i], o[1]);
+            frameChannel(f, &f->b[i], o[2]);
+        }
+        t = (timerTicks() - t);
+        if (t > sXFadeTicksMax)
+        {
+            sXFadeTicksMax = t;
+        }
+    }
+    else
+    {
+        for (uint8_t i=0; i<NUM_LEDS; i++)
         {
-            if (sLEDActive[i])
+            uint8_t *o = sXFadeFrame[i];
+            if (colorMoved(o[0], f->r[i]) || colorMoved(o[1], f->g[i]) || colorMoved(o[2], f->b[i]))
             {
-                sLEDActive[i]--;
+                sChanged++;
             }
+            o[0] = f->r[i];
+            o[1] = f->g[i];
+            o[2] = f->b[i];
         }
+    }
+#else
+    // Without crossfades there is no last frame to compare with, every frame
+    // counts as changed and keeps the full frame rate.
+    sChanged++;
+#endif
+}
 
-        // determine the current LED color
-        getColor(i, sLEDActive[i], &r[i], &g[i], &b[i]);
-        state >>= 1;
+//------------------------------------------------------------------------------
+void crossfadeShown(FRAME_t *f)
+{
+    // Renders between the frames keep the fade step of the last frame, so the
+    // fade advances once per frame however often the LEDs are refreshed.
+#ifdef FEATURE_XFADE
+    if (sXFadeCount)
+    {
+        for (uint8_t i=0; i<NUM_LEDS; i++)
+        {
+            uint8_t *o = sXFadeFrame[i];
+            frameChannel(f, &f->r[i], o[0]);
+            frameChannel(f, &f->g[i], o[1]);
+            frameChannel(f, &f->b[i], o[2]);
+        }
     }
+#endif
+}
 
-    // now update all 16 LEDs
-    for (uint8_t i=0; i<NUM_LEDS; i++)
+//------------------------------------------------------------------------------
+void getXFadeStats(uint16_t *sram, uint16_t *maxTicks)
+{
+#ifdef FEATURE_XFADE
+    *sram = (sizeof(sXFadeFrame) + sizeof(sXFadeCount));
+#else
+    *sram = 0;
+#endif
+    *maxTicks = sXFadeTicksMax;
+}
+
+//------------------------------------------------------------------------------
+void getPowerStats(uint16_t *peak, uint16_t *avg, uint32_t *limited)
+{
+    *peak = sPowerPeak;
+    *avg = (sPowerAvg >> POWER_AVG_SHIFT);
+    *limited = sPowerLimited;
+}
+
+//------------------------------------------------------------------------------
+static inline uint8_t afterglowBlend(uint8_t active)
+{
+    // a bulb's brightness is the blend, afterglow steps scale up to it
+    if (sFGMode.bulb || !active)
     {
-        sendPixel(r[i], g[i], b[i], true);
+        return active;
     }
+    return (active >= sFGMode.afterglow) ? AG_FULL : (uint8_t)(active * sAGScale);
+}
+
+//------------------------------------------------------------------------------
+void renderLEDs(bool frame)
+{
+    // frame is set for the render of an animation frame, and cleared for the
+    // refreshes and lamp passthrough renders in between
+    FRAME_t f;
 
-    // update the 4 flashers
-    for (uint8_t i=0; i<NUM_FLASHER; i++)
+    // afterglow blends of the saucer LEDs
+    f.lit = 0;
+    for (uint8_t i=0; i<NUM_LEDS; i++)
     {
-        if (!sFlashState)
+        uint8_t ag = afterglowBlend(sLEDActive[i]);
+        if (sMode == SM_ATTACK)
         {
-            // LED off
-            sendPixel(0, 0, 0, false);
+            // fade in the predicted next chase lamp, at most up to the
+            // afterglow blend so a wrong guess never shows as a lit lamp,
+            // or pre-heat the bulb up to half brightness
+            uint8_t lead = chaseLead(i);
+            lead = sFGMode.bulb ? (lead >> 1) : afterglowBlend((lead * sFGMode.afterglow) >> 8);
+            if (lead > ag)
+            {
+                ag = lead;
+            }
         }
-        else
+        f.ag[i] = ag;
+        if (ag)
         {
-            // LED on
-            //sendPixel(0xff, 0xff, 0xff, false);
-            sendPixel(100, 255, 100, false);
+            f.lit++;
         }
     }
-    if (sFlashState)
+
+    // Start from black and draw the background, foreground, particles,
+    // effects and flashers bottom up. The order is fixed, so the layers are
+    // called directly and inlined where the compiler sees fit. Transparent
+    // layers are skipped as a whole.
+    memset(f.r, 0, sizeof(f.r));
+    memset(f.g, 0, sizeof(f.g));
+    memset(f.b, 0, sizeof(f.b));
+    f.sum = 0;
+    if (bgVisible(&f))
     {
-        sFlashState--;
+        renderBackground(&f, BLEND_NORMAL);
     }
-    if (sShakerState)
+    if (fgVisible(&f))
     {
-        sShakerState--;
+        renderForeground(&f, BLEND_NORMAL);
+    }
+    if (particlesVisible(&f))
+    {
+        particlesRender(&f, BLEND_ADD);
+    }
+    if (fxVisible(&f))
+    {
+        fxRender(&f, BLEND_ADD);
+    }
+    if (flasherVisible(&f))
+    {
+        renderFlasher(&f, BLEND_NORMAL);
     }
 
-    // check for configuration changes
-    uint8_t cfg = (~PINC & 0x0f);
-    if (cfg != sCfg)
+    // crossfade from the previous mode, one step per frame
+    if (frame)
     {
-        sCfg = cfg;
-        setMode(sMode);
+        crossfade(&f);
+    }
+    else
+    {
+        crossfadeShown(&f);
     }
 
-    sFrameCnt++;
+    // now update all 16 LEDs and the 4 flashers, scaled down if the
+    // estimated current from the channel sum exceeds the budget
+    uint8_t scale = powerLimit(f.sum, frame);
+    if (scale)
+    {
+        for (uint8_t i=0; i<NUM_PIXELS; i++)
+        {
+            f.r[i] = scale8(f.r[i], scale);
+            f.g[i] = scale8(f.g[i], scale);
+            f.b[i] = scale8(f.b[i], scale);
+        }
+    }
+#ifdef FRAME_MIRROR
+    // the mirror packet is put together before the transmit, so the pixel
+    // stream has no gaps beyond the byte loop
+    for (uint8_t i=0; i<NUM_PIXELS; i++)
+    {
+        mirrorPixel(f.r[i], f.g[i], f.b[i]);
+    }
+#endif
+    for (uint8_t i=0; i<NUM_PIXELS; i++)
+    {
+        sendPixel(f.r[i], f.g[i], f.b[i], (i < NUM_LEDS));
+    }
 }
 
 //------------------------------------------------------------------------------
-void initValues(const LED_MODE_t *ledMode, LED_MODE_VALUES_t *ledModeValues)
+void refreshLEDs()
 {
-    int16_t ofsH = ledMode->ofsH;
-    int16_t ofsV = ledMode->ofsV;
-    uint16_t h = ledMode->startH;
-    uint16_t v = ledMode->startV;
-    for (uint8_t i=0; i<NUM_LEDS; i++)
+    // send the current frame once more without advancing any animation, only
+    // the dithering moves on outside of crossfades
+    if (!sError)
     {
-        ledModeValues->currShakerH = 0;
-        ledModeValues->currH = h;
-        ledModeValues->currSpeedH = ((ofsH < 0) == (ledMode->ofsH < 0)) ? ledMode->speedH : -ledMode->speedH;
-        nextValue(&h, &ofsH, ledMode->startH, ledMode->endH);
-        ledModeValues->currV = v;
-        ledModeValues->currSpeedV = ((ofsV < 0) == (ledMode->ofsV < 0)) ? ledMode->speedV : -ledMode->speedV;
-        nextValue(&v, &ofsV, ledMode->startV, ledMode->endV);
-        ledModeValues++;
+        renderLEDs(false);
     }
 }
 
@@ -403,19 +991,103 @@ void setMode(SAUCER_MODES_t mode)
         sCfgSel = sCfg;
     }
 
+    applyMode(mode);
+}
+
+//------------------------------------------------------------------------------
+void applyMode(SAUCER_MODES_t mode)
+{
     // set the mode parameters
     if ((sCfg < NUM_COLOR_PATTERN) && (mode < SM_NUM))
     {
-        sFGMode = *(skColorPatterns[sCfgSel].fgLEDModes[mode]);
-        sBGMode = *(skColorPatterns[sCfgSel].bgLEDModes[mode]);
+        const COLOR_PATTERNS_t *pat = &skColorPatterns[sCfgSel];
+        memcpy_P(&sFGMode, pgm_read_ptr(&pat->fgLEDModes[mode]), sizeof(LED_MODE_t));
+        memcpy_P(&sBGMode, pgm_read_ptr(&pat->bgLEDModes[mode]), sizeof(LED_MODE_t));
+        sAGScale = sFGMode.afterglow ? (256 / sFGMode.afterglow) : 0;
+        if (!sFGMode.bulb)
+        {
+            // a bulb brightness left by the previous mode is no countdown
+            for (uint8_t i=0; i<NUM_LEDS; i++)
+            {
+                if (sLEDActive[i] > sFGMode.afterglow)
+                {
+                    sLEDActive[i] = sFGMode.afterglow;
+                }
+            }
+        }
+
+        // restart the animations
+        initOscillator(&sFGMode, &sFGOsc);
+        initOscillator(&sBGMode, &sBGOsc);
+        sAnimFrame = 0;
+        sBGRot = 0;
+        sBGCacheValid = 0;
+        clipStart(pgm_read_ptr(&pat->bgClips[mode]));
+        chaseReset();
 
-        // apply mode to all LED values
-        initValues(&sFGMode, &sFGModeValues[0]);
-        initValues(&sBGMode, &sBGModeValues[0]);
+        // fade over from what is currently shown
+        sXFadeCount = XFADE_FRAMES;
 
-        // initialize the animation counter
-        sBGAnimCount = sBGMode.animSpeed;
+        // no particles left over from a previous mode if not desired
+        if (!sFGMode.particles)
+        {
+            particlesClear();
+        }
+        fxClear();
+        fxSweep((sFGMode.effects & FX_SWEEP), fxHue());
 
         sMode = mode;
     }
 }
+
+//------------------------------------------------------------------------------
+uint8_t warmStateChecksum()
+{
+    uint8_t c = WARM_STATE_MAGIC;
+    const uint8_t *p = (const uint8_t*)&sWarmState;
+    for (uint8_t i=0; i<offsetof(WARM_STATE_t, checksum); i++)
+    {
+        c = ((c << 1) | (c >> 7)) ^ *p++;
+    }
+    return c;
+}
+
+//------------------------------------------------------------------------------
+void saveWarmState()
+{
+    sWarmState.mode = sMode;
+    sWarmState.cfg = sCfg;
+    sWarmState.cfgSel = sCfgSel;
+    for (uint8_t i=0; i<SM_NUM; i++)
+    {
+        sWarmState.modeIndicators[i] = sModeIndicators[i];
+    }
+    sWarmState.frameCnt = sFrameCnt;
+    sWarmState.animFrame = sAnimFrame;
+    sWarmState.checksum = warmStateChecksum();
+}
+
+//------------------------------------------------------------------------------
+bool restoreWarmState()
+{
+    // the state is only valid if it has been saved before the reset
+    if ((sWarmState.checksum != warmStateChecksum()) ||
+        (sWarmState.mode >= SM_NUM) || (sWarmState.cfgSel >= NUM_COLOR_PATTERN))
+    {
+        return false;
+    }
+
+    // continue right where we left off, skipping the jingle
+    sCfg = sWarmState.cfg;
+    sCfgSel = sWarmState.cfgSel;
+    for (uint8_t i=0; i<SM_NUM; i++)
+    {
+        sModeIndicators[i] = sWarmState.modeIndicators[i];
+    }
+    sFrameCnt = sWarmState.frameCnt;
+    sBootupJingleCountdown = 0;
+    applyMode(sWarmState.mode);
+    sAnimFrame = sWarmState.animFrame;
+    sXFadeCount = 0;
+    return true;
+}
@@ -35,8 +35,25 @@
 #include <avr/io.h>
 #include <stdbool.h>
 
+#define NUM_LEDS 16
+#define NUM_FLASHER 4
+#define NUM_PIXELS (NUM_LEDS + NUM_FLASHER)
+
 void updateLEDState(uint16_t newState);
-void triggerFlasher();
-void triggerShaker();
-void updateLEDs();
+uint8_t getMode();
+void setConfig(uint8_t cfg);
+void triggerFlasher(uint16_t time);
+void triggerShaker(uint16_t time);
+void updateLEDs(uint8_t steps);
+bool lampPassthrough();
+void showLamps(uint16_t newState);
+uint8_t frameInterval(uint8_t events);
+void refreshLEDs();
+void setDither(bool on);
+void setRenderLevel(uint8_t level);
+void getPowerStats(uint16_t *peak, uint16_t *avg, uint32_t *limited);
+void getXFadeStats(uint16_t *sram, uint16_t *maxTicks);
+void getRateStats(uint32_t *frames, uint32_t *rendered);
 void updateFlasher();
+void latchError();
+bool restoreWarmState();
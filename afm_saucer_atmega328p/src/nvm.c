@@ -0,0 +1,135 @@
+/***********************************************************************
+ *    _   _   _             _     __                                           
+ *   /_\ | |_| |_ __ _  ___| | __/ _|_ __ ___  _ __ ___   /\/\   __ _ _ __ ___ 
+ *  //_\\| __| __/ _` |/ __| |/ / |_| '__/ _ \| '_ ` _ \ /    \ / _` | '__/ __|
+ * /  _  \ |_| || (_| | (__|   <|  _| | | (_) | | | | | / /\/\ \ (_| | |  \__ \
+ * \_/ \_/\__|\__\__,_|\___|_|\_\_| |_|  \___/|_| |_| |_\/    \/\__,_|_|  |___/
+ *
+ *                              ____ ____ ___ 
+ *                              |--< |__, |==]
+ *
+ *                      ____ ____ _  _ ____ ____ ____
+ *                      ==== |--| |__| |___ |=== |--<
+ *
+ *  Copyright (c) 2022 bitfield labs
+ * 
+ ***********************************************************************
+ *  This file is part of the Attack from Mars! RGB saucer project:
+ *  https://github.com/bitfieldlabs/afm_saucer
+ *
+ *  The AfM RGB saucer is free software: you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public License as
+ *  published by the Free Software Foundation, either version 3 of the
+ *  License, or (at your option) any later version.
+ *
+ *  AfM RGB saucer is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with afterglow.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ ***********************************************************************/
+
+#include <avr/interrupt.h>
+#include <util/atomic.h>
+#include "nvm.h"
+
+
+//------------------------------------------------------------------------------
+// global variables
+
+typedef struct NVM_BLOCK_s
+{
+    uint16_t addr;      // EEPROM address
+    const uint8_t *src; // data, unchanged until written
+    uint8_t len;        // number of bytes
+} NVM_BLOCK_t;
+
+// Single producer (main loop) single consumer (EE_READY interrupt) ring
+// buffer like the event queue. The consumer releases a block only after its
+// last byte has been handed to the EEPROM.
+static NVM_BLOCK_t sBlocks[NVM_QUEUE_SIZE];    // block ring buffer
+static volatile uint8_t svHead = 0;            // next block to be queued (producer)
+static volatile uint8_t svTail = 0;            // block being written (consumer)
+static uint8_t sPos = 0;                       // next byte of the block being written
+static uint32_t sWritten = 0;                  // bytes written
+static uint32_t sSkipped = 0;                  // bytes skipped as unchanged
+
+
+//------------------------------------------------------------------------------
+bool nvmWrite(uint16_t addr, const void *src, uint8_t len)
+{
+    uint8_t h = svHead;
+    uint8_t next = ((h + 1) & (NVM_QUEUE_SIZE - 1));
+    if (next == svTail)
+    {
+        // queue full, try again later
+        return false;
+    }
+    NVM_BLOCK_t *b = &sBlocks[h];
+    b->addr = addr;
+    b->src = (const uint8_t*)src;
+    b->len = len;
+    asm volatile ("" ::: "memory");     // publish the block only after it has been written
+    svHead = next;
+
+    // the interrupt keeps firing while the EEPROM is ready
+    EECR |= (1 << EERIE);
+    return true;
+}
+
+//------------------------------------------------------------------------------
+bool nvmBusy()
+{
+    return (svHead != svTail);
+}
+
+//------------------------------------------------------------------------------
+void nvmStats(uint32_t *written, uint32_t *skipped)
+{
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        *written = sWritten;
+        *skipped = sSkipped;
+    }
+}
+
+//------------------------------------------------------------------------------
+// EEPROM ready interrupt
+ISR(EE_READY_vect)
+{
+    // One byte per interrupt, so other interrupts are never held off for
+    // long. A skipped byte returns right away and the interrupt fires again,
+    // a written one takes the EEPROM 3.4ms in the background.
+    uint8_t t = svTail;
+    if (t == svHead)
+    {
+        // all done
+        EECR &= ~(1 << EERIE);
+        return;
+    }
+    NVM_BLOCK_t *b = &sBlocks[t];
+    if (sPos >= b->len)
+    {
+        // block done
+        sPos = 0;
+        svTail = ((t + 1) & (NVM_QUEUE_SIZE - 1));
+        return;
+    }
+
+    uint8_t v = b->src[sPos];
+    EEAR = (b->addr + sPos);
+    sPos++;
+    EECR |= (1 << EERE);
+    if (EEDR == v)
+    {
+        sSkipped++;
+        return;
+    }
+    EEDR = v;
+    EECR |= (1 << EEMPE);
+    EECR |= (1 << EEPE);        // within 4 cycles of EEMPE
+    sWritten++;
+}
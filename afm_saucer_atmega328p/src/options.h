@@ -0,0 +1,61 @@
+/***********************************************************************
+ *    _   _   _             _     __                                           
+ *   /_\ | |_| |_ __ _  ___| | __/ _|_ __ ___  _ __ ___   /\/\   __ _ _ __ ___ 
+ *  //_\\| __| __/ _` |/ __| |/ / |_| '__/ _ \| '_ ` _ \ /    \ / _` | '__/ __|
+ * /  _  \ |_| || (_| | (__|   <|  _| | | (_) | | | | | / /\/\ \ (_| | |  \__ \
+ * \_/ \_/\__|\__\__,_|\___|_|\_\_| |_|  \___/|_| |_| |_\/    \/\__,_|_|  |___/
+ *
+ *                              ____ ____ ___ 
+ *                              |--< |__, |==]
+ *
+ *                      ____ ____ _  _ ____ ____ ____
+ *                      ==== |--| |__| |___ |=== |--<
+ *
+ *  Copyright (c) 2022 bitfield labs
+ * 
+ ***********************************************************************
+ *  This file is part of the Attack from Mars! RGB saucer project:
+ *  https://github.com/bitfieldlabs/afm_saucer
+ *
+ *  The AfM RGB saucer is free software: you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public License as
+ *  published by the Free Software Foundation, either version 3 of the
+ *  License, or (at your option) any later version.
+ *
+ *  AfM RGB saucer is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with afterglow.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ ***********************************************************************/
+
+// Optional features. The ATmega328P builds everything, the parts with 1KB
+// SRAM strip what does not fit their flash and SRAM:
+//
+//   SAUCER_SMALL   ATmega168PA, 16KB flash: no clips, effects or usage counters
+//   SAUCER_TINY    ATmega88PA, 8KB flash: SAUCER_SMALL without particles, chase
+//                  prediction, render governor, crossfades and wavetables
+//
+// Stripped modules keep their interface as inline no-ops, so callers need no
+// conditionals of their own.
+
+#if defined(SAUCER_TINY) && !defined(SAUCER_SMALL)
+#define SAUCER_SMALL
+#endif
+
+#ifndef SAUCER_SMALL
+#define FEATURE_CLIPS           // precomputed background clips
+#define FEATURE_FX              // geometric effects: shockwave, sweep and ripple
+#define FEATURE_USAGE           // usage counters in the EEPROM
+#endif
+
+#ifndef SAUCER_TINY
+#define FEATURE_PARTICLES       // shaker sparkles and flasher bursts
+#define FEATURE_CHASE           // attack chase prediction
+#define FEATURE_GOVERNOR        // render degradation near the deadline, with the background cache
+#define FEATURE_XFADE           // crossfades between modes
+#define FEATURE_WAVETABLES      // sine and ease wavetables, computed approximations otherwise
+#endif
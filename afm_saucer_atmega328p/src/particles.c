@@ -0,0 +1,179 @@
+/***********************************************************************
+ *    _   _   _             _     __                                           
+ *   /_\ | |_| |_ __ _  ___| | __/ _|_ __ ___  _ __ ___   /\/\   __ _ _ __ ___ 
+ *  //_\\| __| __/ _` |/ __| |/ / |_| '__/ _ \| '_ ` _ \ /    \ / _` | '__/ __|
+ * /  _  \ |_| || (_| | (__|   <|  _| | | (_) | | | | | / /\/\ \ (_| | |  \__ \
+ * \_/ \_/\__|\__\__,_|\___|_|\_\_| |_|  \___/|_| |_| |_\/    \/\__,_|_|  |___/
+ *
+ *                              ____ ____ ___ 
+ *                              |--< |__, |==]
+ *
+ *                      ____ ____ _  _ ____ ____ ____
+ *                      ==== |--| |__| |___ |=== |--<
+ *
+ *  Copyright (c) 2022 bitfield labs
+ * 
+ ***********************************************************************
+ *  This file is part of the Attack from Mars! RGB saucer project:
+ *  https://github.com/bitfieldlabs/afm_saucer
+ *
+ *  The AfM RGB saucer is free software: you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public License as
+ *  published by the Free Software Foundation, either version 3 of the
+ *  License, or (at your option) any later version.
+ *
+ *  AfM RGB saucer is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with afterglow.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ ***********************************************************************/
+
+#include <stdlib.h>
+#include "particles.h"
+#include "modes.h"
+#include "utils.h"
+#include "layers.h"
+
+#ifdef FEATURE_PARTICLES
+
+
+//------------------------------------------------------------------------------
+// definitions
+
+#define POS_SCALE 256                           // sub-LED position resolution
+#define POS_MASK ((NUM_LEDS * POS_SCALE) - 1)   // ring position wrap around
+
+#define SPARKLE_SPEED_MAX 48                    // maximum sparkle speed [1/POS_SCALE LEDs per frame]
+#define SPARKLE_FADE_MIN 6                      // sparkle fading [value per frame]
+#define SPARKLE_FADE_RANGE 10
+#define BURST_PARTICLES 4                       // particles spawned by a burst
+#define BURST_SPEED 96                          // burst particle speed [1/POS_SCALE LEDs per frame]
+#define BURST_FADE 12                           // burst particle fading [value per frame]
+
+
+//------------------------------------------------------------------------------
+// global variables
+
+typedef struct PARTICLE_s
+{
+    uint16_t pos;       // ring position * POS_SCALE
+    int8_t speed;       // position change per frame
+    uint8_t hue;        // colour hue
+    uint8_t value;      // brightness, 0 marks a free slot
+    uint8_t fade;       // brightness decrease per frame
+} PARTICLE_t;
+
+static PARTICLE_t sParticles[PARTICLE_POOL_SIZE];   // particle pool
+
+
+//------------------------------------------------------------------------------
+PARTICLE_t * allocParticle()
+{
+    // take a free slot or replace the dimmest particle, so bursts never
+    // exceed the pool
+    PARTICLE_t *p = &sParticles[0];
+    for (uint8_t i=1; (i<PARTICLE_POOL_SIZE) && p->value; i++)
+    {
+        if (sParticles[i].value < p->value)
+        {
+            p = &sParticles[i];
+        }
+    }
+    return p;
+}
+
+//------------------------------------------------------------------------------
+void spawnParticle(uint16_t pos, int8_t speed, uint8_t hue, uint8_t fade)
+{
+    PARTICLE_t *p = allocParticle();
+    p->pos = pos;
+    p->speed = speed;
+    p->hue = hue;
+    p->value = 255;
+    p->fade = fade;
+}
+
+//------------------------------------------------------------------------------
+void particlesSparkle()
+{
+    // a single random particle drifting off in a random direction
+    int8_t speed = (rand() % (2 * SPARKLE_SPEED_MAX + 1)) - SPARKLE_SPEED_MAX;
+    spawnParticle((rand() & POS_MASK), speed, (uint8_t)rand(),
+                  SPARKLE_FADE_MIN + (rand() % SPARKLE_FADE_RANGE));
+}
+
+//------------------------------------------------------------------------------
+void particlesBurst(uint8_t hue)
+{
+    // particles running around the ring in both directions from a random LED
+    uint16_t pos = ((rand() % NUM_LEDS) * POS_SCALE);
+    for (uint8_t i=0; i<BURST_PARTICLES; i++)
+    {
+        int8_t speed = (BURST_SPEED >> (i >> 1));
+        spawnParticle(pos, (i & 0x01) ? speed : -speed, hue, BURST_FADE);
+    }
+}
+
+//------------------------------------------------------------------------------
+void particlesClear()
+{
+    for (uint8_t i=0; i<PARTICLE_POOL_SIZE; i++)
+    {
+        sParticles[i].value = 0;
+    }
+}
+
+//------------------------------------------------------------------------------
+void particlesAdvance()
+{
+    PARTICLE_t *p = &sParticles[0];
+    for (uint8_t i=0; i<PARTICLE_POOL_SIZE; i++)
+    {
+        if (p->value)
+        {
+            p->pos = ((p->pos + p->speed) & POS_MASK);
+            p->value = (p->value > p->fade) ? (p->value - p->fade) : 0;
+        }
+        p++;
+    }
+}
+
+//------------------------------------------------------------------------------
+bool particlesActive()
+{
+    for (uint8_t i=0; i<PARTICLE_POOL_SIZE; i++)
+    {
+        if (sParticles[i].value)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+//------------------------------------------------------------------------------
+void particlesRender(FRAME_t *f, uint8_t blend)
+{
+    // draw all particles, each one spread over the two LEDs next to its
+    // position
+    const PARTICLE_t *p = &sParticles[0];
+    for (uint8_t i=0; i<PARTICLE_POOL_SIZE; i++)
+    {
+        if (p->value)
+        {
+            uint8_t pr, pg, pb;
+            hsv2rgb(p->hue, 255, p->value, &pr, &pg, &pb);
+            uint8_t ix = (p->pos / POS_SCALE);
+            uint8_t frac = (p->pos & (POS_SCALE - 1));
+            layerPixel(f, ix, pr, pg, pb, blend, 255 - frac);
+            layerPixel(f, ((ix + 1) % NUM_LEDS), pr, pg, pb, blend, frac);
+        }
+        p++;
+    }
+}
+
+#endif
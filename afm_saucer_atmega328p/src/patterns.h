@@ -33,8 +33,14 @@
  ***********************************************************************/
 
 #include <avr/io.h>
+#include <avr/pgmspace.h>
+#include "waves.h"
+#include "clips.h"
+#include "fx.h"
 
 #define VSCALE 16       // HSV scale for LED modes   ** CHOOSE A POWER OF 2 **
+#define SPEED_MAX (16*VSCALE - 1)   // largest animation speed magnitude * VSCALE [per frame]
+#define BULB(rise, decay) (((rise) << 4) | (decay))  // incandescent bulb time constants [2^n frames]
 
 // saucer LED modes
 typedef enum SAUCER_MODES_e 
@@ -48,39 +54,40 @@ typedef enum SAUCER_MODES_e
     SM_NUM              // number of saucer modes
 } SAUCER_MODES_t;
 
+// phaseInc() shifts the speed by 23 bits in 32 bit arithmetic
+_Static_assert(SPEED_MAX < 256, "SPEED_MAX must fit phaseInc()");
+
 typedef struct LED_MODE_s
 {
     uint16_t startH;    // start hue * VSCALE
     uint16_t endH;      // end hue * VSCALE
     uint16_t startV;    // start value * VSCALE
     uint16_t endV;      // end value * VSCALE
-    int16_t speedH;     // hue animation speed * VSCALE
-    int16_t speedV;     // value animation speed * VSCALE
+    int16_t speedH;     // hue animation speed * VSCALE [per frame], up to +-SPEED_MAX
+    int16_t speedV;     // value animation speed * VSCALE [per frame], up to +-SPEED_MAX
     int16_t ofsH;       // per-LED hue offset * VSCALE
     int16_t ofsV;       // per-LED value offset * VSCALE
     uint8_t afterglow;  // LED afterglow [steps]   ** CHOOSE A POWER OF 2 **
+    uint8_t bulb;       // incandescent bulb emulation BULB(rise, decay) replacing the afterglow, 0 for none
     uint8_t animSpeed;  // animation frame delay
     uint8_t blinkInt;   // blinking interval [2^n frames], only applied for background patterns!
-    bool animDir;       // animation direction, true means clockwise
+    uint8_t wave : 2;           // value waveform (WAVE_t), the hue always uses WAVE_TRIANGLE
+    uint8_t effects : 3;        // geometric effects (FX_t flags), only applied for foreground patterns!
+    bool animDir : 1;           // animation direction, true means clockwise
+    bool particles : 1;         // shaker and flasher particle effects, only applied for foreground patterns!
+    bool passthrough : 1;       // lamp frames shown right away between animation frames, only applied for foreground patterns!
 } LED_MODE_t;
 
-// complete color patterns, defining the behavior for all saucer modes
+// complete color patterns, defining the behavior for all saucer modes, all
+// in PROGMEM like the modes and clips they point to
 typedef struct COLOR_PATTERNS_s
 {
     const LED_MODE_t * fgLEDModes[SM_NUM];    // Foreground LED modes for all saucer modes
     const LED_MODE_t * bgLEDModes[SM_NUM];    // Background LED modes for all saucer modes
+    const CLIP_t * bgClips[SM_NUM];           // Background clips replacing the background modes, NULL for none
 } COLOR_PATTERNS_t;
 
-typedef struct LED_MODE_VALUES_s
-{
-    uint16_t currH;     // current hue*VSCALE for first LED
-    uint16_t currShakerH;     // current hue*VSCALE for first LED when shaking
-    uint16_t currV;     // current value*VSCALE for first LED
-    int16_t currSpeedH; // current hue speed (signed)
-    int16_t currSpeedV; // current value speed (signed)
-} LED_MODE_VALUES_t;
-
-static const LED_MODE_t skCMOff =
+static const LED_MODE_t skCMOff PROGMEM =
 {
     .startH = 0*VSCALE,
     .endH = 0*VSCALE,
@@ -90,13 +97,18 @@ static const LED_MODE_t skCMOff =
     .speedV = 0,
     .ofsH = 0,
     .ofsV = 0,
+    .wave = WAVE_TRIANGLE,
     .afterglow = 0,
+    .bulb = 0,
     .animSpeed = 0,
     .blinkInt = 0,
-    .animDir = false
+    .animDir = false,
+    .particles = true,
+    .effects = 0,
+    .passthrough = false
 };
 
-static const LED_MODE_t skCMBoot =
+static const LED_MODE_t skCMBoot PROGMEM =
 {
     .startH = 0*VSCALE,
     .endH = 255*VSCALE,
@@ -106,13 +118,18 @@ static const LED_MODE_t skCMBoot =
     .speedV = 40,
     .ofsH = 16*VSCALE,
     .ofsV = 0,
+    .wave = WAVE_TRIANGLE,
     .afterglow = 0,
+    .bulb = 0,
     .animSpeed = 2,
     .blinkInt = 0,
-    .animDir = false
+    .animDir = false,
+    .particles = true,
+    .effects = 0,
+    .passthrough = false
 };
 
-static const LED_MODE_t skCMRed =
+static const LED_MODE_t skCMRed PROGMEM =
 {
     .startH = 0*VSCALE,
     .endH = 16*VSCALE,
@@ -122,13 +139,18 @@ static const LED_MODE_t skCMRed =
     .speedV = 0,
     .ofsH = 0,
     .ofsV = 0,
+    .wave = WAVE_TRIANGLE,
     .afterglow = 8,
+    .bulb = 0,
     .animSpeed = 0,
     .blinkInt = 0,
-    .animDir = false
+    .animDir = false,
+    .particles = true,
+    .effects = 0,
+    .passthrough = false
 };
 
-static const LED_MODE_t skCMGreen =
+static const LED_MODE_t skCMGreen PROGMEM =
 {
     .startH = 82*VSCALE,
     .endH = 86*VSCALE,
@@ -138,13 +160,18 @@ static const LED_MODE_t skCMGreen =
     .speedV = 0,
     .ofsH = 0,
     .ofsV = 0,
+    .wave = WAVE_TRIANGLE,
     .afterglow = 8,
+    .bulb = 0,
     .animSpeed = 0,
     .blinkInt = 0,
-    .animDir = false
+    .animDir = false,
+    .particles = true,
+    .effects = 0,
+    .passthrough = false
 };
 
-static const LED_MODE_t skCMBlue =
+static const LED_MODE_t skCMBlue PROGMEM =
 {
     .startH = 160*VSCALE,
     .endH = 166*VSCALE,
@@ -154,13 +181,18 @@ static const LED_MODE_t skCMBlue =
     .speedV = 0,
     .ofsH = 0,
     .ofsV = 0,
+    .wave = WAVE_TRIANGLE,
     .afterglow = 8,
+    .bulb = 0,
     .animSpeed = 0,
     .blinkInt = 0,
-    .animDir = false
+    .animDir = false,
+    .particles = true,
+    .effects = 0,
+    .passthrough = false
 };
 
-static const LED_MODE_t skCMRedOrig =
+static const LED_MODE_t skCMRedOrig PROGMEM =
 {
     .startH = 0*VSCALE,
     .endH = 0*VSCALE,
@@ -170,13 +202,18 @@ static const LED_MODE_t skCMRedOrig =
     .speedV = 0,
     .ofsH = 0,
     .ofsV = 0,
+    .wave = WAVE_TRIANGLE,
     .afterglow = 1,
+    .bulb = BULB(1, 2),
     .animSpeed = 0,
     .blinkInt = 0,
-    .animDir = false
+    .animDir = false,
+    .particles = false,
+    .effects = 0,
+    .passthrough = true
 };
 
-static const LED_MODE_t skCMBrightRedOrange =
+static const LED_MODE_t skCMBrightRedOrange PROGMEM =
 {
     .startH = 2*VSCALE,
     .endH = 24*VSCALE,
@@ -186,13 +223,18 @@ static const LED_MODE_t skCMBrightRedOrange =
     .speedV = 0,
     .ofsH = 2,
     .ofsV = 0,
+    .wave = WAVE_TRIANGLE,
     .afterglow = 16,
+    .bulb = 0,
     .animSpeed = 0,
     .blinkInt = 0,
-    .animDir = false
+    .animDir = false,
+    .particles = true,
+    .effects = 0,
+    .passthrough = false
 };
 
-static const LED_MODE_t skCMRainbow =
+static const LED_MODE_t skCMRainbow PROGMEM =
 {
     .startH = 0*VSCALE,
     .endH = 255*VSCALE,
@@ -202,13 +244,18 @@ static const LED_MODE_t skCMRainbow =
     .speedV = 0,
     .ofsH = 16*VSCALE,
     .ofsV = 0,
+    .wave = WAVE_TRIANGLE,
     .afterglow = 8,
+    .bulb = 0,
     .animSpeed = 0,
     .blinkInt = 0,
-    .animDir = false
+    .animDir = false,
+    .particles = true,
+    .effects = 0,
+    .passthrough = false
 };
 
-static const LED_MODE_t skCMTealPulse =
+static const LED_MODE_t skCMTealPulse PROGMEM =
 {
     .startH = 103*VSCALE,
     .endH = 180*VSCALE,
@@ -218,13 +265,18 @@ static const LED_MODE_t skCMTealPulse =
     .speedV = 0,
     .ofsH = 4,
     .ofsV = 4,
+    .wave = WAVE_TRIANGLE,
     .afterglow = 4,
+    .bulb = 0,
     .animSpeed = 4,
     .blinkInt = 0,
-    .animDir = false
+    .animDir = false,
+    .particles = true,
+    .effects = 0,
+    .passthrough = false
 };
 
-static const LED_MODE_t skCMYellowPulse =
+static const LED_MODE_t skCMYellowPulse PROGMEM =
 {
     .startH = 30*VSCALE,
     .endH = 38*VSCALE,
@@ -234,13 +286,18 @@ static const LED_MODE_t skCMYellowPulse =
     .speedV = 0,
     .ofsH = 2,
     .ofsV = 4,
+    .wave = WAVE_TRIANGLE,
     .afterglow = 4,
+    .bulb = 0,
     .animSpeed = 4,
     .blinkInt = 0,
-    .animDir = false
+    .animDir = false,
+    .particles = true,
+    .effects = 0,
+    .passthrough = false
 };
 
-static const LED_MODE_t skCMBlueBreathe =
+static const LED_MODE_t skCMBlueBreathe PROGMEM =
 {
     .startH = 153*VSCALE,
     .endH = 170*VSCALE,
@@ -250,13 +307,18 @@ static const LED_MODE_t skCMBlueBreathe =
     .speedV = 1,
     .ofsH = 0,
     .ofsV = 0,
+    .wave = WAVE_SINE,
     .afterglow = 4,
+    .bulb = 0,
     .animSpeed = 0,
     .blinkInt = 0,
-    .animDir = false
+    .animDir = false,
+    .particles = true,
+    .effects = 0,
+    .passthrough = false
 };
 
-static const LED_MODE_t skCMGreenBreathe =
+static const LED_MODE_t skCMGreenBreathe PROGMEM =
 {
     .startH = 78*VSCALE,
     .endH = 84*VSCALE,
@@ -266,13 +328,18 @@ static const LED_MODE_t skCMGreenBreathe =
     .speedV = 1,
     .ofsH = 0,
     .ofsV = 0,
+    .wave = WAVE_SINE,
     .afterglow = 4,
+    .bulb = 0,
     .animSpeed = 0,
     .blinkInt = 0,
-    .animDir = false
+    .animDir = false,
+    .particles = true,
+    .effects = 0,
+    .passthrough = false
 };
 
-static const LED_MODE_t skCMYellowGreenBreathe =
+static const LED_MODE_t skCMYellowGreenBreathe PROGMEM =
 {
     .startH = 50*VSCALE,
     .endH = 58*VSCALE,
@@ -282,13 +349,18 @@ static const LED_MODE_t skCMYellowGreenBreathe =
     .speedV = 1,
     .ofsH = 2,
     .ofsV = 2,
+    .wave = WAVE_SINE,
     .afterglow = 4,
+    .bulb = 0,
     .animSpeed = 8,
     .blinkInt = 0,
-    .animDir = false
+    .animDir = false,
+    .particles = true,
+    .effects = 0,
+    .passthrough = false
 };
 
-static const LED_MODE_t skCMRedGreenBreathe =
+static const LED_MODE_t skCMRedGreenBreathe PROGMEM =
 {
     .startH = 2*VSCALE,
     .endH = 82*VSCALE,
@@ -298,13 +370,18 @@ static const LED_MODE_t skCMRedGreenBreathe =
     .speedV = 8,
     .ofsH = 80,
     .ofsV = 0,
+    .wave = WAVE_SINE,
     .afterglow = 4,
+    .bulb = 0,
     .animSpeed = 0,
     .blinkInt = 0,
-    .animDir = false
+    .animDir = false,
+    .particles = true,
+    .effects = 0,
+    .passthrough = false
 };
 
-static const LED_MODE_t skCMRedGreenPulse =
+static const LED_MODE_t skCMRedGreenPulse PROGMEM =
 {
     .startH = 2*VSCALE,
     .endH = 182*VSCALE,
@@ -314,13 +391,18 @@ static const LED_MODE_t skCMRedGreenPulse =
     .speedV = 24,
     .ofsH = 80,
     .ofsV = 24,
+    .wave = WAVE_TRIANGLE,
     .afterglow = 8,
+    .bulb = 0,
     .animSpeed = 8,
     .blinkInt = 0,
-    .animDir = false
+    .animDir = false,
+    .particles = true,
+    .effects = 0,
+    .passthrough = false
 };
 
-static const LED_MODE_t skCMRainbowPulse =
+static const LED_MODE_t skCMRainbowPulse PROGMEM =
 {
     .startH = 0*VSCALE,
     .endH = 255*VSCALE,
@@ -330,13 +412,18 @@ static const LED_MODE_t skCMRainbowPulse =
     .speedV = 2,
     .ofsH = 16*VSCALE,
     .ofsV = 4,
+    .wave = WAVE_TRIANGLE,
     .afterglow = 4,
+    .bulb = 0,
     .animSpeed = 4,
     .blinkInt = 0,
-    .animDir = false
+    .animDir = false,
+    .particles = true,
+    .effects = 0,
+    .passthrough = false
 };
 
-static const LED_MODE_t skCMYellowBlink =
+static const LED_MODE_t skCMYellowBlink PROGMEM =
 {
     .startH = 30*VSCALE,
     .endH = 38*VSCALE,
@@ -346,13 +433,18 @@ static const LED_MODE_t skCMYellowBlink =
     .speedV = 0,
     .ofsH = 0,
     .ofsV = 0,
+    .wave = WAVE_TRIANGLE,
     .afterglow = 4,
+    .bulb = 0,
     .animSpeed = 0,
     .blinkInt = 4,  // 2^8
-    .animDir = false
+    .animDir = false,
+    .particles = true,
+    .effects = 0,
+    .passthrough = false
 };
 
-static const LED_MODE_t skCMBrightPinkRed =
+static const LED_MODE_t skCMBrightPinkRed PROGMEM =
 {
     .startH = 230*VSCALE,
     .endH = 255*VSCALE,
@@ -362,13 +454,18 @@ static const LED_MODE_t skCMBrightPinkRed =
     .speedV = 0,
     .ofsH = 4,
     .ofsV = 0,
+    .wave = WAVE_TRIANGLE,
     .afterglow = 2,
+    .bulb = 0,
     .animSpeed = 0,
     .blinkInt = 0,
-    .animDir = false
+    .animDir = false,
+    .particles = true,
+    .effects = FX_SHOCKWAVE | FX_RIPPLE,
+    .passthrough = false
 };
 
-static const LED_MODE_t skCMBrightLightBlue =
+static const LED_MODE_t skCMBrightLightBlue PROGMEM =
 {
     .startH = 130*VSCALE,
     .endH = 140*VSCALE,
@@ -378,13 +475,18 @@ static const LED_MODE_t skCMBrightLightBlue =
     .speedV = 0,
     .ofsH = 2,
     .ofsV = 0,
+    .wave = WAVE_TRIANGLE,
     .afterglow = 2,
+    .bulb = 0,
     .animSpeed = 0,
     .blinkInt = 0,
-    .animDir = false
+    .animDir = false,
+    .particles = true,
+    .effects = FX_SHOCKWAVE | FX_SWEEP,
+    .passthrough = false
 };
 
-static const LED_MODE_t skCMAlternate =
+static const LED_MODE_t skCMAlternate PROGMEM =
 {
     .startH = 2*VSCALE,
     .endH = 72*VSCALE,
@@ -394,16 +496,98 @@ static const LED_MODE_t skCMAlternate =
     .speedV = 4,
     .ofsH = 72*VSCALE,
     .ofsV = 0*VSCALE,
+    .wave = WAVE_TRIANGLE,
     .afterglow = 4,
+    .bulb = 0,
     .animSpeed = 10,
     .blinkInt = 0,
-    .animDir = false
+    .animDir = false,
+    .particles = true,
+    .effects = 0,
+    .passthrough = false
 };
 
 
+// Precomputed clips, see tools/README.md. Patterns refer to them with CLIP(),
+// which leaves them out of builds without clips.
+#ifdef FEATURE_CLIPS
+#define CLIP(c) (&(c))
+#else
+#define CLIP(c) NULL
+#endif
+
+#ifdef FEATURE_CLIPS
+// attack_comet.txt, 32 frames, 852 bytes (1536 uncompressed)
+static const uint8_t skClipAttackCometData[] PROGMEM =
+{
+    0x01, 0xff, 0x20, 0x00, 0x8c, 0x03, 0x10, 0x00, 0x00, 0x40, 0x00, 0x00, 0x90, 0x08, 0x00, 0x00,
+    0x02, 0x90, 0x08, 0x00, 0xff, 0x20, 0x00, 0x8b, 0x03, 0x00, 0x00, 0x00, 0x10, 0x00, 0x00, 0x40,
+    0x00, 0x00, 0x00, 0x03, 0x40, 0x00, 0x00, 0x90, 0x08, 0x00, 0xff, 0x20, 0x00, 0x8b, 0x02, 0x00,
+    0x00, 0x00, 0x10, 0x00, 0x00, 0x00, 0x04, 0x10, 0x00, 0x00, 0x40, 0x00, 0x00, 0x90, 0x08, 0x00,
+    0xff, 0x20, 0x00, 0x8b, 0x01, 0x00, 0x00, 0x00, 0x00, 0x05, 0x00, 0x00, 0x00, 0x10, 0x00, 0x00,
+    0x40, 0x00, 0x00, 0x90, 0x08, 0x00, 0xff, 0x20, 0x00, 0x00, 0x81, 0x05, 0x00, 0x00, 0x00, 0x10,
+    0x00, 0x00, 0x40, 0x00, 0x00, 0x90, 0x08, 0x00, 0xff, 0x20, 0x00, 0x00, 0x82, 0x05, 0x00, 0x00,
+    0x00, 0x10, 0x00, 0x00, 0x40, 0x00, 0x00, 0x90, 0x08, 0x00, 0xff, 0x20, 0x00, 0x00, 0x83, 0x05,
+    0x00, 0x00, 0x00, 0x10, 0x00, 0x00, 0x40, 0x00, 0x00, 0x90, 0x08, 0x00, 0xff, 0x20, 0x00, 0x00,
+    0x84, 0x05, 0x00, 0x00, 0x00, 0x10, 0x00, 0x00, 0x40, 0x00, 0x00, 0x90, 0x08, 0x00, 0xff, 0x20,
+    0x00, 0x00, 0x85, 0x05, 0x00, 0x00, 0x00, 0x10, 0x00, 0x00, 0x40, 0x00, 0x00, 0x90, 0x08, 0x00,
+    0xff, 0x20, 0x00, 0x00, 0x86, 0x05, 0x00, 0x00, 0x00, 0x10, 0x00, 0x00, 0x40, 0x00, 0x00, 0x90,
+    0x08, 0x00, 0xff, 0x20, 0x00, 0x00, 0x87, 0x05, 0x00, 0x00, 0x00, 0x10, 0x00, 0x00, 0x40, 0x00,
+    0x00, 0x90, 0x08, 0x00, 0xff, 0x20, 0x00, 0x00, 0x88, 0x05, 0x00, 0x00, 0x00, 0x10, 0x00, 0x00,
+    0x40, 0x00, 0x00, 0x90, 0x08, 0x00, 0xff, 0x20, 0x00, 0x00, 0x89, 0x05, 0x00, 0x00, 0x00, 0x10,
+    0x00, 0x00, 0x40, 0x00, 0x00, 0x90, 0x08, 0x00, 0xff, 0x20, 0x00, 0x00, 0x8a, 0x05, 0x00, 0x00,
+    0x00, 0x10, 0x00, 0x00, 0x40, 0x00, 0x00, 0x90, 0x08, 0x00, 0xff, 0x20, 0x00, 0x00, 0x8b, 0x05,
+    0x00, 0x00, 0x00, 0x10, 0x00, 0x00, 0x40, 0x00, 0x00, 0x90, 0x08, 0x00, 0xff, 0x20, 0x00, 0x00,
+    0x01, 0xff, 0x20, 0x00, 0x84, 0x04, 0x10, 0x00, 0x00, 0x40, 0x00, 0x00, 0x90, 0x08, 0x00, 0xff,
+    0x20, 0x00, 0x83, 0x04, 0x00, 0x00, 0x00, 0x10, 0x00, 0x00, 0x40, 0x00, 0x00, 0x90, 0x08, 0x00,
+    0x00, 0x02, 0x90, 0x08, 0x00, 0xff, 0x20, 0x00, 0x83, 0x05, 0x00, 0x00, 0x00, 0x10, 0x00, 0x00,
+    0x40, 0x00, 0x00, 0x90, 0x08, 0x00, 0xff, 0x20, 0x00, 0x83, 0x03, 0x00, 0x00, 0x00, 0x10, 0x00,
+    0x00, 0x40, 0x00, 0x00, 0x00, 0x03, 0x40, 0x00, 0x00, 0x90, 0x08, 0x00, 0xff, 0x20, 0x00, 0x83,
+    0x05, 0x00, 0x00, 0x00, 0x10, 0x00, 0x00, 0x40, 0x00, 0x00, 0x90, 0x08, 0x00, 0xff, 0x20, 0x00,
+    0x83, 0x02, 0x00, 0x00, 0x00, 0x10, 0x00, 0x00, 0x00, 0x04, 0x10, 0x00, 0x00, 0x40, 0x00, 0x00,
+    0x90, 0x08, 0x00, 0xff, 0x20, 0x00, 0x83, 0x05, 0x00, 0x00, 0x00, 0x10, 0x00, 0x00, 0x40, 0x00,
+    0x00, 0x90, 0x08, 0x00, 0xff, 0x20, 0x00, 0x83, 0x01, 0x00, 0x00, 0x00, 0x00, 0x05, 0x00, 0x00,
+    0x00, 0x10, 0x00, 0x00, 0x40, 0x00, 0x00, 0x90, 0x08, 0x00, 0xff, 0x20, 0x00, 0x83, 0x05, 0x00,
+    0x00, 0x00, 0x10, 0x00, 0x00, 0x40, 0x00, 0x00, 0x90, 0x08, 0x00, 0xff, 0x20, 0x00, 0x00, 0x81,
+    0x05, 0x00, 0x00, 0x00, 0x10, 0x00, 0x00, 0x40, 0x00, 0x00, 0x90, 0x08, 0x00, 0xff, 0x20, 0x00,
+    0x83, 0x05, 0x00, 0x00, 0x00, 0x10, 0x00, 0x00, 0x40, 0x00, 0x00, 0x90, 0x08, 0x00, 0xff, 0x20,
+    0x00, 0x00, 0x82, 0x05, 0x00, 0x00, 0x00, 0x10, 0x00, 0x00, 0x40, 0x00, 0x00, 0x90, 0x08, 0x00,
+    0xff, 0x20, 0x00, 0x83, 0x05, 0x00, 0x00, 0x00, 0x10, 0x00, 0x00, 0x40, 0x00, 0x00, 0x90, 0x08,
+    0x00, 0xff, 0x20, 0x00, 0x00, 0x83, 0x05, 0x00, 0x00, 0x00, 0x10, 0x00, 0x00, 0x40, 0x00, 0x00,
+    0x90, 0x08, 0x00, 0xff, 0x20, 0x00, 0x83, 0x05, 0x00, 0x00, 0x00, 0x10, 0x00, 0x00, 0x40, 0x00,
+    0x00, 0x90, 0x08, 0x00, 0xff, 0x20, 0x00, 0x00, 0x01, 0xff, 0x20, 0x00, 0x83, 0x05, 0x00, 0x00,
+    0x00, 0x10, 0x00, 0x00, 0x40, 0x00, 0x00, 0x90, 0x08, 0x00, 0xff, 0x20, 0x00, 0x83, 0x04, 0x00,
+    0x00, 0x00, 0x10, 0x00, 0x00, 0x40, 0x00, 0x00, 0x90, 0x08, 0x00, 0x00, 0x02, 0x90, 0x08, 0x00,
+    0xff, 0x20, 0x00, 0x83, 0x05, 0x00, 0x00, 0x00, 0x10, 0x00, 0x00, 0x40, 0x00, 0x00, 0x90, 0x08,
+    0x00, 0xff, 0x20, 0x00, 0x83, 0x03, 0x00, 0x00, 0x00, 0x10, 0x00, 0x00, 0x40, 0x00, 0x00, 0x00,
+    0x03, 0x40, 0x00, 0x00, 0x90, 0x08, 0x00, 0xff, 0x20, 0x00, 0x83, 0x05, 0x00, 0x00, 0x00, 0x10,
+    0x00, 0x00, 0x40, 0x00, 0x00, 0x90, 0x08, 0x00, 0xff, 0x20, 0x00, 0x83, 0x02, 0x00, 0x00, 0x00,
+    0x10, 0x00, 0x00, 0x00, 0x04, 0x10, 0x00, 0x00, 0x40, 0x00, 0x00, 0x90, 0x08, 0x00, 0xff, 0x20,
+    0x00, 0x83, 0x05, 0x00, 0x00, 0x00, 0x10, 0x00, 0x00, 0x40, 0x00, 0x00, 0x90, 0x08, 0x00, 0xff,
+    0x20, 0x00, 0x83, 0x01, 0x00, 0x00, 0x00, 0x00, 0x05, 0x00, 0x00, 0x00, 0x10, 0x00, 0x00, 0x40,
+    0x00, 0x00, 0x90, 0x08, 0x00, 0xff, 0x20, 0x00, 0x83, 0x05, 0x00, 0x00, 0x00, 0x10, 0x00, 0x00,
+    0x40, 0x00, 0x00, 0x90, 0x08, 0x00, 0xff, 0x20, 0x00, 0x00, 0x81, 0x05, 0x00, 0x00, 0x00, 0x10,
+    0x00, 0x00, 0x40, 0x00, 0x00, 0x90, 0x08, 0x00, 0xff, 0x20, 0x00, 0x83, 0x05, 0x00, 0x00, 0x00,
+    0x10, 0x00, 0x00, 0x40, 0x00, 0x00, 0x90, 0x08, 0x00, 0xff, 0x20, 0x00, 0x00, 0x82, 0x05, 0x00,
+    0x00, 0x00, 0x10, 0x00, 0x00, 0x40, 0x00, 0x00, 0x90, 0x08, 0x00, 0xff, 0x20, 0x00, 0x83, 0x05,
+    0x00, 0x00, 0x00, 0x10, 0x00, 0x00, 0x40, 0x00, 0x00, 0x90, 0x08, 0x00, 0xff, 0x20, 0x00, 0x00,
+    0x83, 0x05, 0x00, 0x00, 0x00, 0x10, 0x00, 0x00, 0x40, 0x00, 0x00, 0x90, 0x08, 0x00, 0xff, 0x20,
+    0x00, 0x83, 0x05, 0x00, 0x00, 0x00, 0x10, 0x00, 0x00, 0x40, 0x00, 0x00, 0x90, 0x08, 0x00, 0xff,
+    0x20, 0x00, 0x00, 0xc0,
+};
+
+static const CLIP_t skClipAttackComet PROGMEM =
+{
+    .data = skClipAttackCometData,
+    .frameDelay = 2,
+    .loop = true
+};
+#endif
+
+
 // Definition of all color patterns
 #define NUM_COLOR_PATTERN 16
-static const COLOR_PATTERNS_t skColorPatterns[NUM_COLOR_PATTERN] =
+static const COLOR_PATTERNS_t skColorPatterns[NUM_COLOR_PATTERN] PROGMEM =
 {
     // SM_BOOT, SM_ATTRACT, SM_GAMEIDLE, SM_ATTACK, SM_TEST
 
@@ -414,7 +598,9 @@ static const COLOR_PATTERNS_t skColorPatterns[NUM_COLOR_PATTERN] =
         // foreground modes
         { &skCMOff, &skCMOff, &skCMOff, &skCMOff, &skCMOff },
         // background modes
-        { &skCMBoot, &skCMOff, &skCMOff, &skCMOff, &skCMOff }
+        { &skCMBoot, &skCMOff, &skCMOff, &skCMOff, &skCMOff },
+        // background clips
+        { NULL, NULL, NULL, NULL, NULL }
     },
 
     // ****************** FANCY BACKGROUND PATTERNS *********************
@@ -424,7 +610,9 @@ static const COLOR_PATTERNS_t skColorPatterns[NUM_COLOR_PATTERN] =
         // foreground modes
         { &skCMOff, &skCMRed, &skCMBrightRedOrange, &skCMBrightPinkRed, &skCMRainbow },
         // background modes
-        { &skCMBoot, &skCMTealPulse, &skCMTealPulse, &skCMOff, &skCMOff }
+        { &skCMBoot, &skCMTealPulse, &skCMTealPulse, &skCMOff, &skCMOff },
+        // background clips
+        { NULL, NULL, NULL, NULL, NULL }
     },
 
     // COLOR PATTERN 2
@@ -432,7 +620,9 @@ static const COLOR_PATTERNS_t skColorPatterns[NUM_COLOR_PATTERN] =
         // foreground modes
         { &skCMOff, &skCMRed, &skCMBrightRedOrange, &skCMBrightLightBlue, &skCMRainbow },
         // background modes
-        { &skCMBoot, &skCMRainbowPulse, &skCMRainbowPulse, &skCMOff, &skCMOff }
+        { &skCMBoot, &skCMRainbowPulse, &skCMRainbowPulse, &skCMOff, &skCMOff },
+        // background clips
+        { NULL, NULL, NULL, NULL, NULL }
     },
 
     // COLOR PATTERN 3
@@ -440,7 +630,9 @@ static const COLOR_PATTERNS_t skColorPatterns[NUM_COLOR_PATTERN] =
         // foreground modes
         { &skCMOff, &skCMRed, &skCMBrightRedOrange, &skCMBrightLightBlue, &skCMRainbow },
         // background modes
-        { &skCMBoot, &skCMYellowBlink, &skCMYellowBlink, &skCMOff, &skCMOff }
+        { &skCMBoot, &skCMYellowBlink, &skCMYellowBlink, &skCMOff, &skCMOff },
+        // background clips
+        { NULL, NULL, NULL, NULL, NULL }
     },
 
     // COLOR PATTERN 4
@@ -448,7 +640,9 @@ static const COLOR_PATTERNS_t skColorPatterns[NUM_COLOR_PATTERN] =
         // foreground modes
         { &skCMOff, &skCMRed, &skCMBrightRedOrange, &skCMGreen, &skCMRainbow },
         // background modes
-        { &skCMBoot, &skCMGreenBreathe, &skCMGreenBreathe, &skCMOff, &skCMOff }
+        { &skCMBoot, &skCMGreenBreathe, &skCMGreenBreathe, &skCMOff, &skCMOff },
+        // background clips
+        { NULL, NULL, NULL, NULL, NULL }
     },
 
     // COLOR PATTERN 5
@@ -456,7 +650,9 @@ static const COLOR_PATTERNS_t skColorPatterns[NUM_COLOR_PATTERN] =
         // foreground modes
         { &skCMRed, &skCMRed, &skCMRed, &skCMRed, &skCMRainbow },
         // background modes
-        { &skCMBoot, &skCMOff, &skCMOff, &skCMOff, &skCMOff }
+        { &skCMBoot, &skCMOff, &skCMOff, &skCMOff, &skCMOff },
+        // background clips
+        { NULL, NULL, NULL, NULL, NULL }
     },
 
     // COLOR PATTERN 6
@@ -464,7 +660,9 @@ static const COLOR_PATTERNS_t skColorPatterns[NUM_COLOR_PATTERN] =
         // foreground modes
         { &skCMRed, &skCMRed, &skCMRed, &skCMGreen, &skCMRainbow },
         // background modes
-        { &skCMBoot, &skCMRedGreenBreathe, &skCMRedGreenBreathe, &skCMOff, &skCMOff }
+        { &skCMBoot, &skCMRedGreenBreathe, &skCMRedGreenBreathe, &skCMOff, &skCMOff },
+        // background clips
+        { NULL, NULL, NULL, NULL, NULL }
     },
 
     // COLOR PATTERN 7
@@ -472,7 +670,9 @@ static const COLOR_PATTERNS_t skColorPatterns[NUM_COLOR_PATTERN] =
         // foreground modes
         { &skCMRed, &skCMRed, &skCMRed, &skCMBlue, &skCMRainbow },
         // background modes
-        { &skCMBoot, &skCMRedGreenPulse, &skCMRedGreenPulse, &skCMOff, &skCMOff }
+        { &skCMBoot, &skCMRedGreenPulse, &skCMRedGreenPulse, &skCMOff, &skCMOff },
+        // background clips
+        { NULL, NULL, NULL, NULL, NULL }
     },
 
     // COLOR PATTERN 8
@@ -480,7 +680,9 @@ static const COLOR_PATTERNS_t skColorPatterns[NUM_COLOR_PATTERN] =
         // foreground modes
         { &skCMRed, &skCMRed, &skCMRed, &skCMBlue, &skCMRainbow },
         // background modes
-        { &skCMBoot, &skCMYellowGreenBreathe, &skCMYellowGreenBreathe, &skCMOff, &skCMOff }
+        { &skCMBoot, &skCMYellowGreenBreathe, &skCMYellowGreenBreathe, &skCMOff, &skCMOff },
+        // background clips
+        { NULL, NULL, NULL, NULL, NULL }
     },
 
     // COLOR PATTERN 9
@@ -488,7 +690,9 @@ static const COLOR_PATTERNS_t skColorPatterns[NUM_COLOR_PATTERN] =
         // foreground modes
         { &skCMRed, &skCMRed, &skCMGreen, &skCMRed, &skCMRainbow },
         // background modes
-        { &skCMBoot, &skCMAlternate, &skCMAlternate, &skCMOff, &skCMOff }
+        { &skCMBoot, &skCMAlternate, &skCMAlternate, &skCMOff, &skCMOff },
+        // background clips
+        { NULL, NULL, NULL, CLIP(skClipAttackComet), NULL }
     },
 
     // ****************** NO BACKGROUND PATTERNS *********************
@@ -498,7 +702,9 @@ static const COLOR_PATTERNS_t skColorPatterns[NUM_COLOR_PATTERN] =
         // foreground modes
         { &skCMRainbow, &skCMRainbow, &skCMRainbow, &skCMRainbow, &skCMRainbow },
         // background modes
-        { &skCMBoot, &skCMOff, &skCMOff, &skCMOff, &skCMOff }
+        { &skCMBoot, &skCMOff, &skCMOff, &skCMOff, &skCMOff },
+        // background clips
+        { NULL, NULL, NULL, NULL, NULL }
     },
 
     // COLOR PATTERN 11
@@ -506,7 +712,9 @@ static const COLOR_PATTERNS_t skColorPatterns[NUM_COLOR_PATTERN] =
         // foreground modes
         { &skCMRed, &skCMRed, &skCMGreen, &skCMRainbow, &skCMRed },
         // background modes
-        { &skCMBoot, &skCMOff, &skCMOff, &skCMOff, &skCMOff }
+        { &skCMBoot, &skCMOff, &skCMOff, &skCMOff, &skCMOff },
+        // background clips
+        { NULL, NULL, NULL, NULL, NULL }
     },
 
     // COLOR PATTERN 12
@@ -514,7 +722,9 @@ static const COLOR_PATTERNS_t skColorPatterns[NUM_COLOR_PATTERN] =
         // foreground modes
         { &skCMRed, &skCMRed, &skCMGreen, &skCMBlue, &skCMRed },
         // background modes
-        { &skCMBoot, &skCMOff, &skCMOff, &skCMOff, &skCMOff }
+        { &skCMBoot, &skCMOff, &skCMOff, &skCMOff, &skCMOff },
+        // background clips
+        { NULL, NULL, NULL, NULL, NULL }
     },
 
     // COLOR PATTERN 13
@@ -522,7 +732,9 @@ static const COLOR_PATTERNS_t skColorPatterns[NUM_COLOR_PATTERN] =
         // foreground modes
         { &skCMBlue, &skCMBlue, &skCMBlue, &skCMBlue, &skCMBlue },
         // background modes
-        { &skCMBoot, &skCMOff, &skCMOff, &skCMOff, &skCMOff }
+        { &skCMBoot, &skCMOff, &skCMOff, &skCMOff, &skCMOff },
+        // background clips
+        { NULL, NULL, NULL, NULL, NULL }
     },
 
     // COLOR PATTERN 14
@@ -530,7 +742,9 @@ static const COLOR_PATTERNS_t skColorPatterns[NUM_COLOR_PATTERN] =
         // foreground modes
         { &skCMGreen, &skCMGreen, &skCMGreen, &skCMGreen, &skCMGreen },
         // background modes
-        { &skCMBoot, &skCMOff, &skCMOff, &skCMOff, &skCMOff }
+        { &skCMBoot, &skCMOff, &skCMOff, &skCMOff, &skCMOff },
+        // background clips
+        { NULL, NULL, NULL, NULL, NULL }
     },
 
     // COLOR PATTERN 15
@@ -538,6 +752,8 @@ static const COLOR_PATTERNS_t skColorPatterns[NUM_COLOR_PATTERN] =
         // foreground modes
         { &skCMRedOrig, &skCMRedOrig, &skCMRedOrig, &skCMRedOrig, &skCMRedOrig },
         // background modes
-        { &skCMOff, &skCMOff, &skCMOff, &skCMOff, &skCMOff }
+        { &skCMOff, &skCMOff, &skCMOff, &skCMOff, &skCMOff },
+        // background clips
+        { NULL, NULL, NULL, NULL, NULL }
     },
 };
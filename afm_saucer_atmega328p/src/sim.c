@@ -0,0 +1,116 @@
+/***********************************************************************
+ *    _   _   _             _     __                                           
+ *   /_\ | |_| |_ __ _  ___| | __/ _|_ __ ___  _ __ ___   /\/\   __ _ _ __ ___ 
+ *  //_\\| __| __/ _` |/ __| |/ / |_| '__/ _ \| '_ ` _ \ /    \ / _` | '__/ __|
+ * /  _  \ |_| || (_| | (__|   <|  _| | | (_) | | | | | / /\/\ \ (_| | |  \__ \
+ * \_/ \_/\__|\__\__,_|\___|_|\_\_| |_|  \___/|_| |_| |_\/    \/\__,_|_|  |___/
+ *
+ *                              ____ ____ ___ 
+ *                              |--< |__, |==]
+ *
+ *                      ____ ____ _  _ ____ ____ ____
+ *                      ==== |--| |__| |___ |=== |--<
+ *
+ *  Copyright (c) 2022 bitfield labs
+ * 
+ ***********************************************************************
+ *  This file is part of the Attack from Mars! RGB saucer project:
+ *  https://github.com/bitfieldlabs/afm_saucer
+ *
+ *  The AfM RGB saucer is free software: you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public License as
+ *  published by the Free Software Foundation, either version 3 of the
+ *  License, or (at your option) any later version.
+ *
+ *  AfM RGB saucer is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with afterglow.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ ***********************************************************************/
+
+// simavr support, only built into the *_sim environments. The ELF
+// tells simavr to trace both LED data lines into saucer.vcd and to print the
+// console register, which carries the frames the firmware meant to send.
+// tools/ws2812_vcd.py compares the two, see tools/README.md.
+
+#ifdef SIMAVR_TRACE
+
+#include <avr/avr_mcu_section.h>
+#include "sim.h"
+#include "modes.h"
+
+
+//------------------------------------------------------------------------------
+// definitions
+
+#define SIM_VCD_PERIOD_US 1000          // VCD flush period [us]
+
+
+//------------------------------------------------------------------------------
+// simavr configuration, the 1KB parts run as their plain variants, which only
+// lack the picoPower features the firmware does not use
+
+#if defined(__AVR_ATmega88PA__)
+AVR_MCU(F_CPU, "atmega88");
+#elif defined(__AVR_ATmega168PA__)
+AVR_MCU(F_CPU, "atmega168");
+#else
+AVR_MCU(F_CPU, "atmega328p");
+#endif
+AVR_MCU_VCD_FILE("saucer.vcd", SIM_VCD_PERIOD_US);
+AVR_MCU_SIMAVR_CONSOLE(&SIM_CONSOLE);
+
+const struct avr_mmcu_vcd_trace_t skSimTrace[] _MMCU_ =
+{
+    { AVR_MCU_VCD_SYMBOL("PD5"), .mask = (1 << PD5), .what = (void*)&PORTD, },
+    { AVR_MCU_VCD_SYMBOL("PD6"), .mask = (1 << PD6), .what = (void*)&PORTD, },
+};
+
+
+//------------------------------------------------------------------------------
+// global variables
+
+static uint8_t sSimFrame[NUM_PIXELS][3];   // pixels of the frame being sent
+static uint8_t sSimPixel = 0;              // next pixel in the frame
+
+
+//------------------------------------------------------------------------------
+static void simPutHex(uint8_t v)
+{
+    static const char skHex[] = "0123456789abcdef";
+    SIM_CONSOLE = skHex[v >> 4];
+    SIM_CONSOLE = skHex[v & 0x0f];
+}
+
+//------------------------------------------------------------------------------
+void simPixel(uint8_t r, uint8_t g, uint8_t b)
+{
+    // Only store the pixel while the frame goes out. The whole frame is
+    // printed after its last pixel, when the data lines idle anyway.
+    uint8_t *p = sSimFrame[sSimPixel];
+    p[0] = r;
+    p[1] = g;
+    p[2] = b;
+    if (++sSimPixel < NUM_PIXELS)
+    {
+        return;
+    }
+    sSimPixel = 0;
+
+    // "F rrggbb ... rrggbb"
+    SIM_CONSOLE = 'F';
+    for (uint8_t i=0; i<NUM_PIXELS; i++)
+    {
+        SIM_CONSOLE = ' ';
+        simPutHex(sSimFrame[i][0]);
+        simPutHex(sSimFrame[i][1]);
+        simPutHex(sSimFrame[i][2]);
+    }
+    SIM_CONSOLE = '\n';
+}
+
+#endif
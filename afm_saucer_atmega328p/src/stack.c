@@ -0,0 +1,107 @@
+/***********************************************************************
+ *    _   _   _             _     __                                           
+ *   /_\ | |_| |_ __ _  ___| | __/ _|_ __ ___  _ __ ___   /\/\   __ _ _ __ ___ 
+ *  //_\\| __| __/ _` |/ __| |/ / |_| '__/ _ \| '_ ` _ \ /    \ / _` | '__/ __|
+ * /  _  \ |_| || (_| | (__|   <|  _| | | (_) | | | | | / /\/\ \ (_| | |  \__ \
+ * \_/ \_/\__|\__\__,_|\___|_|\_\_| |_|  \___/|_| |_| |_\/    \/\__,_|_|  |___/
+ *
+ *                              ____ ____ ___ 
+ *                              |--< |__, |==]
+ *
+ *                      ____ ____ _  _ ____ ____ ____
+ *                      ==== |--| |__| |___ |=== |--<
+ *
+ *  Copyright (c) 2022 bitfield labs
+ * 
+ ***********************************************************************
+ *  This file is part of the Attack from Mars! RGB saucer project:
+ *  https://github.com/bitfieldlabs/afm_saucer
+ *
+ *  The AfM RGB saucer is free software: you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public License as
+ *  published by the Free Software Foundation, either version 3 of the
+ *  License, or (at your option) any later version.
+ *
+ *  AfM RGB saucer is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with afterglow.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ ***********************************************************************/
+
+#include "stack.h"
+
+
+//------------------------------------------------------------------------------
+// global variables
+
+extern uint8_t _end;            // end of .data/.bss/.noinit, provided by the linker
+extern uint8_t __stack;         // top of the stack (RAMEND), provided by the linker
+
+
+//------------------------------------------------------------------------------
+// declarations
+
+void stackPaint(void) __attribute__ ((naked, used, section (".init1")));
+
+
+//------------------------------------------------------------------------------
+void stackPaint(void)
+{
+    // Paint the complete area between the end of the static variables and the
+    // top of the stack. This runs before the stack pointer and the zero
+    // register are set up, so no C code is possible here.
+    asm volatile (
+        "    ldi r30, lo8(_end)      \n\t"
+        "    ldi r31, hi8(_end)      \n\t"
+        "    ldi r24, %[canary]      \n\t"
+        "    ldi r25, hi8(__stack)   \n\t"
+        "    rjmp 2f                 \n\t"
+        "1:  st Z+, r24              \n\t"
+        "2:  cpi r30, lo8(__stack)   \n\t"
+        "    cpc r31, r25            \n\t"
+        "    brlo 1b                 \n\t"
+        "    breq 1b                 \n\t"
+        :
+        : [canary] "M" (STACK_CANARY)
+    );
+}
+
+//------------------------------------------------------------------------------
+uint16_t stackUnused()
+{
+    // number of bytes never touched by the stack since reset
+    const uint8_t *p = &_end;
+    uint16_t c = 0;
+    while ((p <= &__stack) && (*p == STACK_CANARY))
+    {
+        p++;
+        c++;
+    }
+    return c;
+}
+
+//------------------------------------------------------------------------------
+uint16_t stackHighWater()
+{
+    // maximum stack depth since reset [bytes]
+    return (uint16_t)(&__stack - &_end) + 1 - stackUnused();
+}
+
+//------------------------------------------------------------------------------
+bool stackOverflow()
+{
+    // the stack reached into the last bytes before the static variables
+    const uint8_t *p = &_end;
+    for (uint8_t i=0; i<STACK_GUARD_SIZE; i++)
+    {
+        if (*p++ != STACK_CANARY)
+        {
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,110 @@
+/***********************************************************************
+ *    _   _   _             _     __                                           
+ *   /_\ | |_| |_ __ _  ___| | __/ _|_ __ ___  _ __ ___   /\/\   __ _ _ __ ___ 
+ *  //_\\| __| __/ _` |/ __| |/ / |_| '__/ _ \| '_ ` _ \ /    \ / _` | '__/ __|
+ * /  _  \ |_| || (_| | (__|   <|  _| | | (_) | | | | | / /\/\ \ (_| | |  \__ \
+ * \_/ \_/\__|\__\__,_|\___|_|\_\_| |_|  \___/|_| |_| |_\/    \/\__,_|_|  |___/
+ *
+ *                              ____ ____ ___ 
+ *                              |--< |__, |==]
+ *
+ *                      ____ ____ _  _ ____ ____ ____
+ *                      ==== |--| |__| |___ |=== |--<
+ *
+ *  Copyright (c) 2022 bitfield labs
+ * 
+ ***********************************************************************
+ *  This file is part of the Attack from Mars! RGB saucer project:
+ *  https://github.com/bitfieldlabs/afm_saucer
+ *
+ *  The AfM RGB saucer is free software: you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public License as
+ *  published by the Free Software Foundation, either version 3 of the
+ *  License, or (at your option) any later version.
+ *
+ *  AfM RGB saucer is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with afterglow.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ ***********************************************************************/
+
+#include "trace.h"
+#include "uart.h"
+#include "events.h"
+#include "timer.h"
+
+
+//------------------------------------------------------------------------------
+// definitions
+
+#define TRACE_TYPE_SHIFT 14     // the upper 2 bits hold the record type
+
+
+//------------------------------------------------------------------------------
+// global variables
+
+typedef struct TRACE_RECORD_s
+{
+    uint16_t typeTime;  // record type (bits 15-14) and time stamp (bits 13-0)
+    uint16_t data;      // record data
+} TRACE_RECORD_t;
+
+static TRACE_RECORD_t sTrace[TRACE_SIZE];      // trace ring buffer
+static uint8_t sTraceHead = 0;                 // next record to be written
+static uint8_t sTraceCount = 0;                // number of valid records
+static uint16_t sTraceLast = 0;                // timer at the last record [ticks]
+static uint32_t sTraceNow = 0;                 // timer extended to 32 bits at the last record [ticks]
+
+
+//------------------------------------------------------------------------------
+void traceRecord(uint8_t type, uint16_t time, uint16_t data)
+{
+    // extend the timer, the event time lies less than a timer period back
+    uint16_t now = timerTicks();
+    sTraceNow += (uint16_t)(now - sTraceLast);
+    sTraceLast = now;
+    uint32_t t = sTraceNow - (uint16_t)(now - time);
+
+    TRACE_RECORD_t *rec = &sTrace[sTraceHead];
+    rec->typeTime = ((uint16_t)type << TRACE_TYPE_SHIFT) | ((t >> TRACE_TIME_SHIFT) & TRACE_TIME_MASK);
+    rec->data = data;
+    sTraceHead = (sTraceHead + 1) % TRACE_SIZE;
+    if (sTraceCount < TRACE_SIZE)
+    {
+        sTraceCount++;
+    }
+}
+
+//------------------------------------------------------------------------------
+void traceDump()
+{
+    // Format, one record per line in hex, oldest first:
+    //   TRACE <count>
+    //   <type> <time> <data>
+    //   END <events lost so far>
+    // Events arriving meanwhile wait in the event queue. The ring is empty
+    // afterwards.
+    uint8_t ix = (sTraceHead + TRACE_SIZE - sTraceCount) % TRACE_SIZE;
+    uartPuts("TRACE ");
+    uartPutHex8(sTraceCount);
+    uartPutc('\n');
+    for (uint8_t i=0; i<sTraceCount; i++)
+    {
+        const TRACE_RECORD_t *rec = &sTrace[ix];
+        uartPutc('0' + (rec->typeTime >> TRACE_TYPE_SHIFT));
+        uartPutc(' ');
+        uartPutHex16(rec->typeTime & TRACE_TIME_MASK);
+        uartPutc(' ');
+        uartPutHex16(rec->data);
+        uartPutc('\n');
+        ix = (ix + 1) % TRACE_SIZE;
+    }
+    uartPuts("END ");
+    uartPutHex8(svEventsLost);
+    uartPutc('\n');
+    sTraceCount = 0;
+}
@@ -0,0 +1,166 @@
+/***********************************************************************
+ *    _   _   _             _     __                                           
+ *   /_\ | |_| |_ __ _  ___| | __/ _|_ __ ___  _ __ ___   /\/\   __ _ _ __ ___ 
+ *  //_\\| __| __/ _` |/ __| |/ / |_| '__/ _ \| '_ ` _ \ /    \ / _` | '__/ __|
+ * /  _  \ |_| || (_| | (__|   <|  _| | | (_) | | | | | / /\/\ \ (_| | |  \__ \
+ * \_/ \_/\__|\__\__,_|\___|_|\_\_| |_|  \___/|_| |_| |_\/    \/\__,_|_|  |___/
+ *
+ *                              ____ ____ ___ 
+ *                              |--< |__, |==]
+ *
+ *                      ____ ____ _  _ ____ ____ ____
+ *                      ==== |--| |__| |___ |=== |--<
+ *
+ *  Copyright (c) 2022 bitfield labs
+ * 
+ ***********************************************************************
+ *  This file is part of the Attack from Mars! RGB saucer project:
+ *  https://github.com/bitfieldlabs/afm_saucer
+ *
+ *  The AfM RGB saucer is free software: you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public License as
+ *  published by the Free Software Foundation, either version 3 of the
+ *  License, or (at your option) any later version.
+ *
+ *  AfM RGB saucer is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with afterglow.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ ***********************************************************************/
+
+#include <avr/interrupt.h>
+#include "uart.h"
+
+
+//------------------------------------------------------------------------------
+// definitions
+
+#define UART_UBRR ((F_CPU / (8UL * UART_BAUD)) - 1)   // double speed mode
+
+
+//------------------------------------------------------------------------------
+// global variables
+
+// Transmit ring buffer, filled by the main loop and emptied by the data
+// register empty interrupt. Bytes are put behind the published head and only
+// handed to the interrupt on commit, so packets go out complete.
+static uint8_t sTxBuf[UART_TX_SIZE];           // transmit ring buffer
+static volatile uint8_t svTxHead = 0;          // end of the published bytes (producer)
+static volatile uint8_t svTxTail = 0;          // next byte to send (consumer)
+static uint8_t sTxPut = 0;                     // end of the put bytes, svTxHead after the next commit
+
+
+//------------------------------------------------------------------------------
+void uartInit()
+{
+    UBRR0 = UART_UBRR;
+    UCSR0A = (1 << U2X0);
+    UCSR0B = (1 << RXEN0) | (1 << TXEN0);
+    UCSR0C = (1 << UCSZ01) | (1 << UCSZ00); // 8N1
+}
+
+//------------------------------------------------------------------------------
+uint8_t uartTxFree()
+{
+    return ((svTxTail - sTxPut - 1) & (UART_TX_SIZE - 1));
+}
+
+//------------------------------------------------------------------------------
+void uartTxPut(uint8_t v)
+{
+    // the caller makes sure there is space
+    sTxBuf[sTxPut] = v;
+    sTxPut = ((sTxPut + 1) & (UART_TX_SIZE - 1));
+}
+
+//------------------------------------------------------------------------------
+void uartTxCommit()
+{
+    asm volatile ("" ::: "memory");     // publish the bytes only after they have been written
+    svTxHead = sTxPut;
+    UCSR0B |= (1 << UDRIE0);
+}
+
+//------------------------------------------------------------------------------
+void uartPutc(char c)
+{
+    while (!uartTxFree())
+    {
+        // wait for the transmit buffer to become free
+    }
+    uartTxPut(c);
+    uartTxCommit();
+}
+
+//------------------------------------------------------------------------------
+void uartPuts(const char *s)
+{
+    while (*s)
+    {
+        uartPutc(*s++);
+    }
+}
+
+//------------------------------------------------------------------------------
+void uartPutHex8(uint8_t v)
+{
+    static const char skHex[] = "0123456789abcdef";
+    uartPutc(skHex[v >> 4]);
+    uartPutc(skHex[v & 0x0f]);
+}
+
+//------------------------------------------------------------------------------
+void uartPutHex16(uint16_t v)
+{
+    uartPutHex8(v >> 8);
+    uartPutHex8(v & 0xff);
+}
+
+//------------------------------------------------------------------------------
+void uartPutDec(uint32_t v)
+{
+    char buf[11];
+    uint8_t i = 0;
+    do
+    {
+        buf[i++] = '0' + (v % 10);
+        v /= 10;
+    } while (v);
+    while (i)
+    {
+        uartPutc(buf[--i]);
+    }
+}
+
+//------------------------------------------------------------------------------
+int16_t uartGetc()
+{
+    // non-blocking, returns -1 if no character has been received
+    if (UCSR0A & (1 << RXC0))
+    {
+        return UDR0;
+    }
+    return -1;
+}
+
+#ifdef UART_ENABLED
+//------------------------------------------------------------------------------
+// transmit data register empty interrupt, only linked into the serial builds
+// as it keeps the transmit buffer
+ISR(USART_UDRE_vect)
+{
+    uint8_t t = svTxTail;
+    if (t == svTxHead)
+    {
+        // all sent
+        UCSR0B &= ~(1 << UDRIE0);
+        return;
+    }
+    UDR0 = sTxBuf[t];
+    svTxTail = ((t + 1) & (UART_TX_SIZE - 1));
+}
+#endif
@@ -0,0 +1,58 @@
+/***********************************************************************
+ *    _   _   _             _     __                                           
+ *   /_\ | |_| |_ __ _  ___| | __/ _|_ __ ___  _ __ ___   /\/\   __ _ _ __ ___ 
+ *  //_\\| __| __/ _` |/ __| |/ / |_| '__/ _ \| '_ ` _ \ /    \ / _` | '__/ __|
+ * /  _  \ |_| || (_| | (__|   <|  _| | | (_) | | | | | / /\/\ \ (_| | |  \__ \
+ * \_/ \_/\__|\__\__,_|\___|_|\_\_| |_|  \___/|_| |_| |_\/    \/\__,_|_|  |___/
+ *
+ *                              ____ ____ ___ 
+ *                              |--< |__, |==]
+ *
+ *                      ____ ____ _  _ ____ ____ ____
+ *                      ==== |--| |__| |___ |=== |--<
+ *
+ *  Copyright (c) 2022 bitfield labs
+ * 
+ ***********************************************************************
+ *  This file is part of the Attack from Mars! RGB saucer project:
+ *  https://github.com/bitfieldlabs/afm_saucer
+ *
+ *  The AfM RGB saucer is free software: you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public License as
+ *  published by the Free Software Foundation, either version 3 of the
+ *  License, or (at your option) any later version.
+ *
+ *  AfM RGB saucer is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with afterglow.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ ***********************************************************************/
+
+#include <avr/io.h>
+#include <stdbool.h>
+
+#define UART_BAUD 115200        // serial baud rate on the PD0/PD1 pins
+#define UART_TX_SIZE 128        // transmit buffer size [bytes]   ** CHOOSE A POWER OF 2 **
+
+// the serial port is only used by the debugging builds
+#if defined(TRACE_RECORDER) || defined(SAUCER_DEBUG) || defined(FRAME_MIRROR)
+#define UART_ENABLED
+#endif
+
+void uartInit();
+void uartPutc(char c);
+void uartPuts(const char *s);
+void uartPutHex8(uint8_t v);
+void uartPutHex16(uint16_t v);
+void uartPutDec(uint32_t v);
+int16_t uartGetc();
+
+// Non-blocking transmission for the render loop: check the space, put the
+// bytes and publish them at once with uartTxCommit().
+uint8_t uartTxFree();
+void uartTxPut(uint8_t v);
+void uartTxCommit();
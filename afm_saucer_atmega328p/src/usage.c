@@ -0,0 +1,227 @@
+/***********************************************************************
+ *    _   _   _             _     __                                           
+ *   /_\ | |_| |_ __ _  ___| | __/ _|_ __ ___  _ __ ___   /\/\   __ _ _ __ ___ 
+ *  //_\\| __| __/ _` |/ __| |/ / |_| '__/ _ \| '_ ` _ \ /    \ / _` | '__/ __|
+ * /  _  \ |_| || (_| | (__|   <|  _| | | (_) | | | | | / /\/\ \ (_| | |  \__ \
+ * \_/ \_/\__|\__\__,_|\___|_|\_\_| |_|  \___/|_| |_| |_\/    \/\__,_|_|  |___/
+ *
+ *                              ____ ____ ___ 
+ *                              |--< |__, |==]
+ *
+ *                      ____ ____ _  _ ____ ____ ____
+ *                      ==== |--| |__| |___ |=== |--<
+ *
+ *  Copyright (c) 2022 bitfield labs
+ * 
+ ***********************************************************************
+ *  This file is part of the Attack from Mars! RGB saucer project:
+ *  https://github.com/bitfieldlabs/afm_saucer
+ *
+ *  The AfM RGB saucer is free software: you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public License as
+ *  published by the Free Software Foundation, either version 3 of the
+ *  License, or (at your option) any later version.
+ *
+ *  AfM RGB saucer is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with afterglow.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ ***********************************************************************/
+
+#include <stddef.h>
+#include <string.h>
+#include <avr/eeprom.h>
+#include "usage.h"
+#include "nvm.h"
+#include "uart.h"
+#include "patterns.h"
+
+#ifdef FEATURE_USAGE
+
+
+//------------------------------------------------------------------------------
+// definitions
+
+#define USAGE_BASE 0x040                    // EEPROM address of the first record slot, the seed is at 0
+#define USAGE_SLOTS 16                      // records written round robin for wear levelling
+#define USAGE_MAGIC 0x5a                    // checksum start value
+#define USAGE_FLUSH_INT 15                  // flush interval [min], each slot is written every USAGE_SLOTS * USAGE_FLUSH_INT minutes
+#define USAGE_FIRST_FLUSH 1                 // first flush after boot, persists the reset counters early [min]
+#define MS_PER_MIN 60000U
+
+
+//------------------------------------------------------------------------------
+// global variables
+
+typedef struct USAGE_s
+{
+    uint32_t minutes[SM_NUM];           // time spent in each saucer mode [min]
+    uint32_t attacks;                   // saucer attacks
+    uint32_t flashes;                   // flasher triggers
+    uint16_t boots;                     // power-on resets
+    uint16_t wdResets;                  // watchdog resets
+    uint16_t seq;                       // record sequence number, the highest is the latest
+    uint8_t checksum;                   // checksum over all fields above
+} USAGE_t;
+
+static USAGE_t sUsage;                         // counters, coalesced in RAM
+static USAGE_t sRecord;                        // record being written to the EEPROM
+static uint8_t sSlot = 0;                      // slot of the latest record
+static uint16_t sModeMs[SM_NUM] = { 0 };       // time in each saucer mode not yet counted [ms]
+static uint16_t sUptimeMs = 0;                 // time not yet counted for the flush interval [ms]
+static uint8_t sFlushCountdown = USAGE_FIRST_FLUSH;    // minutes until the next flush
+static uint8_t sLastMode = SM_NUM;             // saucer mode of the last frame
+
+
+//------------------------------------------------------------------------------
+static uint8_t usageChecksum(const USAGE_t *u)
+{
+    uint8_t c = USAGE_MAGIC;
+    const uint8_t *p = (const uint8_t*)u;
+    for (uint8_t i=0; i<offsetof(USAGE_t, checksum); i++)
+    {
+        c = ((c << 1) | (c >> 7)) ^ *p++;
+    }
+    return c;
+}
+
+//------------------------------------------------------------------------------
+static uint16_t slotAddr(uint8_t slot)
+{
+    return (USAGE_BASE + (slot * sizeof(USAGE_t)));
+}
+
+//------------------------------------------------------------------------------
+void usageInit(uint8_t resetFlags)
+{
+    // continue from the valid record with the highest sequence number, the
+    // numbers wrap around
+    memset(&sUsage, 0, sizeof(sUsage));
+    bool found = false;
+    for (uint8_t i=0; i<USAGE_SLOTS; i++)
+    {
+        eeprom_read_block(&sRecord, (const void*)(uintptr_t)slotAddr(i), sizeof(sRecord));
+        if ((sRecord.checksum == usageChecksum(&sRecord)) &&
+            (!found || ((int16_t)(sRecord.seq - sUsage.seq) > 0)))
+        {
+            sUsage = sRecord;
+            sSlot = i;
+            found = true;
+        }
+    }
+
+    if (resetFlags & (1 << PORF))
+    {
+        sUsage.boots++;
+    }
+    if (resetFlags & (1 << WDRF))
+    {
+        sUsage.wdResets++;
+    }
+}
+
+//------------------------------------------------------------------------------
+static void usageFlush()
+{
+    // The previous record must be completely written, otherwise try again
+    // next minute. Only the bytes which changed are written.
+    if (nvmBusy())
+    {
+        sFlushCountdown = 1;
+        return;
+    }
+    sUsage.seq++;
+    sRecord = sUsage;
+    sRecord.checksum = usageChecksum(&sRecord);
+    uint8_t slot = ((sSlot + 1) % USAGE_SLOTS);
+    if (nvmWrite(slotAddr(slot), &sRecord, sizeof(sRecord)))
+    {
+        sSlot = slot;
+        sFlushCountdown = USAGE_FLUSH_INT;
+    }
+    else
+    {
+        sFlushCountdown = 1;
+    }
+}
+
+//------------------------------------------------------------------------------
+void usageTime(uint8_t mode, uint8_t ms)
+{
+    // called every frame, a few additions unless a minute is complete
+    if ((mode == SM_ATTACK) && (sLastMode != SM_ATTACK))
+    {
+        sUsage.attacks++;
+    }
+    sLastMode = mode;
+
+    if (mode < SM_NUM)
+    {
+        sModeMs[mode] += ms;
+        if (sModeMs[mode] >= MS_PER_MIN)
+        {
+            sModeMs[mode] -= MS_PER_MIN;
+            sUsage.minutes[mode]++;
+        }
+    }
+
+    sUptimeMs += ms;
+    if (sUptimeMs >= MS_PER_MIN)
+    {
+        sUptimeMs -= MS_PER_MIN;
+        sFlushCountdown--;
+        if (sFlushCountdown == 0)
+        {
+            usageFlush();
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+void usageFlash()
+{
+    sUsage.flashes++;
+}
+
+#ifdef UART_ENABLED
+//------------------------------------------------------------------------------
+static void printCounter(const char *name, uint32_t v)
+{
+    uartPuts(name);
+    uartPutc(' ');
+    uartPutDec(v);
+    uartPutc('\n');
+}
+
+//------------------------------------------------------------------------------
+void usageDump()
+{
+    // one "<name> <value>" line per counter, like the debug statistics
+    static const char * const skModeNames[SM_NUM] =
+    {
+        "minutes_boot", "minutes_attract", "minutes_gameidle", "minutes_attack", "minutes_test"
+    };
+    uartPuts("USAGE\n");
+    for (uint8_t i=0; i<SM_NUM; i++)
+    {
+        printCounter(skModeNames[i], sUsage.minutes[i]);
+    }
+    printCounter("attacks", sUsage.attacks);
+    printCounter("flashes", sUsage.flashes);
+    printCounter("boots", sUsage.boots);
+    printCounter("watchdog_resets", sUsage.wdResets);
+    printCounter("record_seq", sUsage.seq);
+    printCounter("record_slot", sSlot);
+    uint32_t written, skipped;
+    nvmStats(&written, &skipped);
+    printCounter("eeprom_written", written);
+    printCounter("eeprom_skipped", skipped);
+    uartPuts("END\n");
+}
+#endif
+
+#endif
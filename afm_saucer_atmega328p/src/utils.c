@@ -32,13 +32,14 @@
  *  If not, see <http://www.gnu.org/licenses/>.
  ***********************************************************************/
 
+#include <avr/pgmspace.h>
 #include "utils.h"
 
 // using the principle from https://graphics.stanford.edu/~seander/bithacks.html
 
 
 //------------------------------------------------------------------------------
-static const unsigned char skBitsSetTable256[256] = 
+static const unsigned char skBitsSetTable256[256] PROGMEM = 
 {
 #   define B2(n) n,     n+1,     n+1,     n+2
 #   define B4(n) B2(n), B2(n+1), B2(n+1), B2(n+2)
@@ -49,7 +50,7 @@ static const unsigned char skBitsSetTable256[256] =
 //------------------------------------------------------------------------------
 uint8_t bitsSet(uint16_t v)
 {
-    return (skBitsSetTable256[v & 0xff] + skBitsSetTable256[(v >> 8) & 0xff]);
+    return (pgm_read_byte(&skBitsSetTable256[v & 0xff]) + pgm_read_byte(&skBitsSetTable256[(v >> 8) & 0xff]));
 }
 
 //------------------------------------------------------------------------------
@@ -100,6 +101,7 @@ uint8_t blend8( uint8_t a, uint8_t b, uint8_t amountOfB)
     // 1 or 2 cycles depending on how the compiler optimises
     partial = (a << 8) | b;
 
+#ifdef __AVR__
     // 7 cycles
     asm volatile (
         "  mul %[a], %[amountOfB]        \n\t"
@@ -115,8 +117,28 @@ uint8_t blend8( uint8_t a, uint8_t b, uint8_t amountOfB)
           [b] "r" (b)
         : "r0", "r1"
     );
+#else
+    // portable version for host builds
+    partial += (b * amountOfB);
+    partial -= (a * amountOfB);
+#endif
    
     result = partial >> 8;
    
     return result;
-}
\ No newline at end of file
+}
+
+//------------------------------------------------------------------------------
+uint8_t scale8(uint8_t v, uint8_t scale)
+{
+    // v * scale / 256
+    return (((uint16_t)v * scale) >> 8);
+}
+
+//------------------------------------------------------------------------------
+uint8_t qadd8(uint8_t a, uint8_t b)
+{
+    // saturating add
+    uint16_t s = (uint16_t)a + b;
+    return (s > 255) ? 255 : s;
+}
@@ -36,4 +36,6 @@
 
 uint8_t bitsSet(uint16_t v);
 void hsv2rgb(uint8_t H, uint8_t S, uint8_t V, uint8_t *R, uint8_t *G, uint8_t *B);
-uint8_t blend8( uint8_t a, uint8_t b, uint8_t amountOfB);
\ No newline at end of file
+uint8_t blend8( uint8_t a, uint8_t b, uint8_t amountOfB);
+uint8_t scale8(uint8_t v, uint8_t scale);
+uint8_t qadd8(uint8_t a, uint8_t b);
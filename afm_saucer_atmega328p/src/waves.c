@@ -0,0 +1,166 @@
+/***********************************************************************
+ *    _   _   _             _     __                                           
+ *   /_\ | |_| |_ __ _  ___| | __/ _|_ __ ___  _ __ ___   /\/\   __ _ _ __ ___ 
+ *  //_\\| __| __/ _` |/ __| |/ / |_| '__/ _ \| '_ ` _ \ /    \ / _` | '__/ __|
+ * /  _  \ |_| || (_| | (__|   <|  _| | | (_) | | | | | / /\/\ \ (_| | |  \__ \
+ * \_/ \_/\__|\__\__,_|\___|_|\_\_| |_|  \___/|_| |_| |_\/    \/\__,_|_|  |___/
+ *
+ *                              ____ ____ ___ 
+ *                              |--< |__, |==]
+ *
+ *                      ____ ____ _  _ ____ ____ ____
+ *                      ==== |--| |__| |___ |=== |--<
+ *
+ *  Copyright (c) 2022 bitfield labs
+ * 
+ ***********************************************************************
+ *  This file is part of the Attack from Mars! RGB saucer project:
+ *  https://github.com/bitfieldlabs/afm_saucer
+ *
+ *  The AfM RGB saucer is free software: you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public License as
+ *  published by the Free Software Foundation, either version 3 of the
+ *  License, or (at your option) any later version.
+ *
+ *  AfM RGB saucer is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with afterglow.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ ***********************************************************************/
+
+#include <avr/pgmspace.h>
+#include "options.h"
+#include "waves.h"
+
+#ifdef FEATURE_WAVETABLES
+
+//------------------------------------------------------------------------------
+// Wavetables, one full period each, generated by tools/gen_waves.py
+static const uint8_t skWaves[WAVE_NUM][256] PROGMEM =
+{
+    // WAVE_TRIANGLE
+    {
+          0,   2,   4,   6,   8,  10,  12,  14,  16,  18,  20,  22,  24,  26,  28,  30,
+         32,  34,  36,  38,  40,  42,  44,  46,  48,  50,  52,  54,  56,  58,  60,  62,
+         64,  66,  68,  70,  72,  74,  76,  78,  80,  82,  84,  86,  88,  90,  92,  94,
+         96,  98, 100, 102, 104, 106, 108, 110, 112, 114, 116, 118, 120, 122, 124, 126,
+        128, 130, 132, 134, 136, 138, 140, 142, 144, 146, 148, 150, 152, 154, 156, 158,
+        160, 162, 164, 166, 168, 170, 172, 174, 176, 178, 180, 182, 184, 186, 188, 190,
+        192, 194, 196, 198, 200, 202, 204, 206, 208, 210, 212, 214, 216, 218, 220, 222,
+        224, 226, 228, 230, 232, 234, 236, 238, 240, 242, 244, 246, 248, 250, 252, 254,
+        255, 254, 252, 250, 248, 246, 244, 242, 240, 238, 236, 234, 232, 230, 228, 226,
+        224, 222, 220, 218, 216, 214, 212, 210, 208, 206, 204, 202, 200, 198, 196, 194,
+        192, 190, 188, 186, 184, 182, 180, 178, 176, 174, 172, 170, 168, 166, 164, 162,
+        160, 158, 156, 154, 152, 150, 148, 146, 144, 142, 140, 138, 136, 134, 132, 130,
+        128, 126, 124, 122, 120, 118, 116, 114, 112, 110, 108, 106, 104, 102, 100,  98,
+         96,  94,  92,  90,  88,  86,  84,  82,  80,  78,  76,  74,  72,  70,  68,  66,
+         64,  62,  60,  58,  56,  54,  52,  50,  48,  46,  44,  42,  40,  38,  36,  34,
+         32,  30,  28,  26,  24,  22,  20,  18,  16,  14,  12,  10,   8,   6,   4,   2,
+    },
+    // WAVE_SINE
+    {
+          0,   0,   0,   0,   1,   1,   1,   2,   2,   3,   4,   5,   5,   6,   7,   9,
+         10,  11,  12,  14,  15,  17,  18,  20,  21,  23,  25,  27,  29,  31,  33,  35,
+         37,  40,  42,  44,  47,  49,  52,  54,  57,  59,  62,  65,  67,  70,  73,  76,
+         79,  82,  85,  88,  90,  93,  97, 100, 103, 106, 109, 112, 115, 118, 121, 124,
+        127, 131, 134, 137, 140, 143, 146, 149, 152, 155, 158, 162, 165, 167, 170, 173,
+        176, 179, 182, 185, 188, 190, 193, 196, 198, 201, 203, 206, 208, 211, 213, 215,
+        218, 220, 222, 224, 226, 228, 230, 232, 234, 235, 237, 238, 240, 241, 243, 244,
+        245, 246, 248, 249, 250, 250, 251, 252, 253, 253, 254, 254, 254, 255, 255, 255,
+        255, 255, 255, 255, 254, 254, 254, 253, 253, 252, 251, 250, 250, 249, 248, 246,
+        245, 244, 243, 241, 240, 238, 237, 235, 234, 232, 230, 228, 226, 224, 222, 220,
+        218, 215, 213, 211, 208, 206, 203, 201, 198, 196, 193, 190, 188, 185, 182, 179,
+        176, 173, 170, 167, 165, 162, 158, 155, 152, 149, 146, 143, 140, 137, 134, 131,
+        128, 124, 121, 118, 115, 112, 109, 106, 103, 100,  97,  93,  90,  88,  85,  82,
+         79,  76,  73,  70,  67,  65,  62,  59,  57,  54,  52,  49,  47,  44,  42,  40,
+         37,  35,  33,  31,  29,  27,  25,  23,  21,  20,  18,  17,  15,  14,  12,  11,
+         10,   9,   7,   6,   5,   5,   4,   3,   2,   2,   1,   1,   1,   0,   0,   0,
+    },
+    // WAVE_EASE
+    {
+          0,   0,   0,   0,   1,   1,   2,   2,   3,   4,   4,   5,   6,   7,   9,  10,
+         11,  12,  14,  15,  17,  18,  20,  22,  24,  26,  27,  29,  31,  34,  36,  38,
+         40,  42,  45,  47,  50,  52,  54,  57,  60,  62,  65,  67,  70,  73,  76,  78,
+         81,  84,  87,  90,  93,  96,  98, 101, 104, 107, 110, 113, 116, 119, 122, 125,
+        128, 131, 134, 137, 140, 143, 146, 149, 152, 155, 158, 161, 164, 167, 170, 172,
+        175, 178, 181, 183, 186, 189, 192, 194, 197, 199, 202, 204, 207, 209, 211, 214,
+        216, 218, 220, 222, 225, 227, 228, 230, 232, 234, 236, 237, 239, 240, 242, 243,
+        245, 246, 247, 248, 249, 250, 251, 252, 252, 253, 254, 254, 254, 255, 255, 255,
+        255, 255, 255, 255, 254, 254, 254, 253, 252, 252, 251, 250, 249, 248, 247, 246,
+        245, 243, 242, 240, 239, 237, 236, 234, 232, 230, 228, 227, 225, 222, 220, 218,
+        216, 214, 211, 209, 207, 204, 202, 199, 197, 194, 192, 189, 186, 183, 181, 178,
+        175, 172, 170, 167, 164, 161, 158, 155, 152, 149, 146, 143, 140, 137, 134, 131,
+        128, 125, 122, 119, 116, 113, 110, 107, 104, 101,  98,  96,  93,  90,  87,  84,
+         81,  78,  76,  73,  70,  67,  65,  62,  60,  57,  54,  52,  50,  47,  45,  42,
+         40,  38,  36,  34,  31,  29,  27,  26,  24,  22,  20,  18,  17,  15,  14,  12,
+         11,  10,   9,   7,   6,   5,   4,   4,   3,   2,   2,   1,   1,   0,   0,   0,
+    },
+    // WAVE_SQUARE
+    {
+          0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+          0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+          0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+          0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+          0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+          0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+          0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+          0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+        255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+        255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+        255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+        255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+        255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+        255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+        255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+        255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+    },
+};
+
+//------------------------------------------------------------------------------
+uint16_t waveSample(uint8_t wave, uint16_t phase)
+{
+    // linear interpolation between the table entries, returns 0..65535
+    const uint8_t *t = skWaves[wave];
+    uint8_t ix = (phase >> 8);
+    uint8_t frac = (phase & 0xff);
+    uint16_t w0 = pgm_read_byte(&t[ix]);
+    uint16_t w1 = pgm_read_byte(&t[(uint8_t)(ix + 1)]);
+    uint16_t w = (w0 * (256 - frac)) + (w1 * frac);
+    return (w + (w >> 8));
+}
+
+#else
+
+//------------------------------------------------------------------------------
+uint16_t waveSample(uint8_t wave, uint16_t phase)
+{
+    // Computed instead of the wavetables, returns 0..65535. The sine is
+    // replaced by the ease curve x^2 * (3 - 2x), which stays within 1.1% of it.
+    if (wave == WAVE_SQUARE)
+    {
+        // the edges take 1/256 of the period, like with the table
+        uint8_t ix = (phase >> 8);
+        if ((ix == 0x7f) || (ix == 0xff))
+        {
+            uint16_t ramp = ((phase & 0xff) << 8);
+            return (ix == 0x7f) ? ramp : (0xffff - ramp);
+        }
+        return (phase & 0x8000) ? 0xffff : 0;
+    }
+    // triangle scaled by 257/256 like the table interpolation, which makes up
+    // for the truncation of the oscillator values
+    uint16_t t = (phase & 0x8000) ? ((uint16_t)~phase << 1) : (phase << 1);
+    t = ((t >= 0xff00) ? 0xffff : (t + (t >> 8)));
+    if (wave == WAVE_TRIANGLE)
+    {
+        return t;
+    }
+    uint32_t x2 = (((uint32_t)t * t) >> 16);
+    return (uint16_t)((x2 * ((0x30000UL - 2 * (uint32_t)t) >> 2)) >> 14);
+}
+
+#endif
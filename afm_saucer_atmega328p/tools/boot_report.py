@@ -0,0 +1,54 @@
+#
+# Attack from Mars! RGB saucer - bootloader footprint report
+#
+# PlatformIO extra script for the ATmega328P_boot environment, prints the
+# flash used by the bootloader and its largest functions after linking. The
+# build fails if the bootloader does not fit the boot section.
+
+import os
+import subprocess
+import sys
+
+Import('env')
+
+sys.path.insert(0, env.subst(os.path.join('$PROJECT_DIR', 'tools')))
+from elf_sections import section_sizes
+
+TOP_SYMBOLS = 8         # number of largest functions listed
+
+
+def code_symbols(nm, elf):
+    syms = []
+    out = subprocess.check_output([nm, '-S', '--size-sort', '-r', elf], universal_newlines=True)
+    for line in out.splitlines():
+        fields = line.split()
+        if len(fields) == 4 and fields[2] in 'tT':
+            syms.append((int(fields[1], 16), fields[3]))
+    return syms[:TOP_SYMBOLS]
+
+
+def boot_report(source, target, env):
+    elf = str(target[0])
+    sizetool = env.subst('$SIZETOOL')
+    nm = sizetool.replace('size', 'nm')
+    section = int(env.BoardConfig().get('upload.maximum_size', 2048))
+
+    sizes = section_sizes(sizetool, elf)
+    text = sizes.get('.text', 0)
+    data = sizes.get('.data', 0)
+    free = section - text - data
+
+    print('Bootloader flash footprint (%d byte boot section):' % section)
+    print('  .text    %5d' % text)
+    print('  .data    %5d' % data)
+    print('  free     %5d' % free)
+    print('Largest functions:')
+    for size, name in code_symbols(nm, elf):
+        print('  %5d  %s' % (size, name))
+
+    if free < 0:
+        print('Error: the bootloader exceeds the boot section by %d bytes' % -free)
+        env.Exit(1)
+
+
+env.AddPostAction('$BUILD_DIR/${PROGNAME}.elf', boot_report)
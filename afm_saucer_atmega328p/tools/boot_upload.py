@@ -0,0 +1,210 @@
+#!/usr/bin/env python3
+#
+# Attack from Mars! RGB saucer - serial bootloader upload
+#
+# Compresses an Intel HEX firmware image with LZSS and uploads it to the
+# bootloader in the boot section (src/boot/boot.h describes the protocol).
+# Reset or power cycle the saucer after starting the upload. While a valid
+# application is installed, the bootloader only listens for 0.5s after
+# power on.
+#
+#   boot_upload.py [-p /dev/ttyUSB0] firmware.hex
+#   boot_upload.py --dump stream.bin firmware.hex
+#
+# --dump writes the host side byte stream to a file instead of uploading.
+# The simavr test in sim/ plays it. Uploading requires pyserial.
+
+import argparse
+import binascii
+import struct
+import sys
+import time
+
+APP_MAX = 0x7780        # boot section start minus the image record page
+LZ_MIN = 3              # shortest back reference
+LZ_MAX = LZ_MIN + 15    # longest back reference
+LZ_WINDOW = 4096        # farthest back reference
+LZ_CHAIN = 256          # candidates searched per position
+BLOCK_SIZE = 255        # compressed bytes per data block
+RETRIES = 3             # transmissions of a rejected block
+ACK_TIMEOUT = 1.0       # reply timeout [s]
+SYNC_TIMEOUT = 30.0     # time for resetting the saucer [s]
+
+SYNC = b'U'
+READY = b'B'
+HEADER = b'H'
+DATA = b'D'
+FINISH = b'F'
+ACK = b'K'
+NAK = b'E'
+BAD_CRC = b'C'
+
+
+def read_hex(path):
+    image = bytearray()
+    base = 0
+    with open(path) as f:
+        for num, line in enumerate(f, 1):
+            line = line.strip()
+            if not line:
+                continue
+            if not line.startswith(':'):
+                sys.exit('%s:%d: not an Intel HEX record' % (path, num))
+            rec = bytes.fromhex(line[1:])
+            if sum(rec) & 0xff:
+                sys.exit('%s:%d: checksum error' % (path, num))
+            count, addr, rtype = rec[0], (rec[1] << 8) | rec[2], rec[3]
+            payload = rec[4:4 + count]
+            if rtype == 0x00:
+                end = base + addr + count
+                if end > len(image):
+                    image.extend(b'\xff' * (end - len(image)))
+                image[base + addr:end] = payload
+            elif rtype == 0x01:
+                break
+            elif rtype == 0x02:
+                base = ((payload[0] << 8) | payload[1]) << 4
+            elif rtype == 0x04:
+                base = ((payload[0] << 8) | payload[1]) << 16
+    if len(image) > APP_MAX:
+        sys.exit('%s: image of %d bytes exceeds the %d bytes below the bootloader' %
+                 (path, len(image), APP_MAX))
+    return bytes(image)
+
+
+def crc_xmodem(data):
+    return binascii.crc_hqx(data, 0)
+
+
+def longest_match(data, pos, chains):
+    best_len, best_dist = 0, 0
+    end = min(len(data), pos + LZ_MAX)
+    for cand in reversed(chains.get(data[pos:pos + LZ_MIN], ())[-LZ_CHAIN:]):
+        dist = pos - cand
+        if dist > LZ_WINDOW:
+            break
+        n = 0
+        while pos + n < end and data[cand + n] == data[pos + n]:
+            n += 1
+        if n > best_len:
+            best_len, best_dist = n, dist
+            if n == LZ_MAX:
+                break
+    return best_len, best_dist
+
+
+def compress(data):
+    # greedy LZSS with one step lazy matching, see BOOT_LZ_MIN in src/boot/boot.h
+    out = bytearray()
+    items = []
+    chains = {}
+
+    def add(pos):
+        chains.setdefault(data[pos:pos + LZ_MIN], []).append(pos)
+
+    pos = 0
+    while pos < len(data):
+        n, dist = longest_match(data, pos, chains)
+        if n >= LZ_MIN and pos + 1 < len(data):
+            add(pos)
+            n2, _ = longest_match(data, pos + 1, chains)
+            chains[data[pos:pos + LZ_MIN]].pop()
+            if n2 > n:
+                n = 0
+        if n >= LZ_MIN:
+            d = dist - 1
+            items.append((d & 0xff, ((d >> 8) << 4) | (n - LZ_MIN)))
+        else:
+            n = 1
+            items.append(data[pos])
+        for p in range(pos, pos + n):
+            add(p)
+        pos += n
+
+    for i in range(0, len(items), 8):
+        group = items[i:i + 8]
+        flags = 0
+        body = bytearray()
+        for bit, item in enumerate(group):
+            if isinstance(item, int):
+                flags |= (1 << bit)
+                body.append(item)
+            else:
+                body.extend(item)
+        out.append(flags)
+        out.extend(body)
+    return bytes(out)
+
+
+def commands(image, packed):
+    # the host side of an upload, (command bytes, expected reply)
+    yield HEADER + struct.pack('<HH', len(image), crc_xmodem(image)), ACK
+    for num, i in enumerate(range(0, len(packed), BLOCK_SIZE)):
+        ix = bytes([num & 0xff])
+        block = packed[i:i + BLOCK_SIZE]
+        yield DATA + ix + bytes([len(block)]) + block + struct.pack('<H', crc_xmodem(ix + block)), ACK + ix
+    yield FINISH, ACK
+
+
+def reply(port, timeout, size=1):
+    port.timeout = timeout
+    return port.read(size)
+
+
+def upload(port, image, packed):
+    print('reset the saucer now', file=sys.stderr)
+    deadline = time.monotonic() + SYNC_TIMEOUT
+    while reply(port, 0.05) != READY:
+        if time.monotonic() > deadline:
+            sys.exit('no answer from the bootloader')
+        port.write(SYNC)
+    time.sleep(0.05)
+    port.reset_input_buffer()
+
+    start = time.monotonic()
+    cmds = list(commands(image, packed))
+    for num, (cmd, expected) in enumerate(cmds, 1):
+        for attempt in range(RETRIES):
+            # a block whose acknowledge got lost is acknowledged again
+            # without being decompressed twice
+            port.write(cmd)
+            r = reply(port, ACK_TIMEOUT, len(expected))
+            if r == expected:
+                break
+            port.reset_input_buffer()
+            if r[:1] == BAD_CRC:
+                sys.exit('image CRC mismatch, the application was not started')
+        else:
+            sys.exit('command %d/%d rejected (%r)' % (num, len(cmds), r))
+        print('\r%3d%%' % (100 * num // len(cmds)), end='', file=sys.stderr)
+    print('\rdone in %.1fs' % (time.monotonic() - start), file=sys.stderr)
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Upload firmware to the saucer bootloader')
+    parser.add_argument('-p', '--port', default='/dev/ttyUSB0', help='serial port')
+    parser.add_argument('-b', '--baud', type=int, default=115200, help='baud rate')
+    parser.add_argument('--dump', metavar='FILE', help='write the host byte stream instead')
+    parser.add_argument('hex', help='Intel HEX firmware image')
+    args = parser.parse_args()
+
+    image = read_hex(args.hex)
+    packed = compress(image)
+    print('image %d bytes, compressed %d bytes (%d%%), CRC %04x' %
+          (len(image), len(packed), 100 * len(packed) // max(len(image), 1), crc_xmodem(image)),
+          file=sys.stderr)
+
+    if args.dump:
+        with open(args.dump, 'wb') as f:
+            f.write(SYNC)
+            for cmd, _ in commands(image, packed):
+                f.write(cmd)
+        return
+
+    import serial
+    with serial.Serial(args.port, args.baud) as port:
+        upload(port, image, packed)
+
+
+if __name__ == '__main__':
+    main()
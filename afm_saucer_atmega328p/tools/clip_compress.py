@@ -0,0 +1,104 @@
+#!/usr/bin/env python3
+#
+# Attack from Mars! RGB saucer - animation clip compressor
+#
+# Reads a clip as text, one frame per line with the colours of the 16
+# saucer LEDs in wiring order as rrggbb hex words. The flashers are left
+# to the flasher layer. Blank lines and everything after '#' are ignored.
+#
+# Each frame is encoded as the difference to the previous one (the first
+# to black) in runs of skipped, filled and literal pixels, see
+# src/clips.h. The result is printed as a PROGMEM array for patterns.h.
+#
+#   clip_compress.py clips/attack_comet.txt skClipAttackCometData
+
+import sys
+
+NUM_LEDS = 16       # saucer LEDs, the flashers are not part of a clip
+
+OP_LITERAL = 0x00
+OP_FILL = 0x40
+OP_SKIP = 0x80
+RUN_MAX = 0x3f
+END_FRAME = 0x00
+END_CLIP = 0xc0
+
+
+def parse(path):
+    frames = []
+    with open(path) as f:
+        for num, line in enumerate(f, 1):
+            words = line.split('#')[0].split()
+            if not words:
+                continue
+            if len(words) != NUM_LEDS:
+                sys.exit('%s:%d: %d pixels, expected %d' % (path, num, len(words), NUM_LEDS))
+            frames.append([tuple(bytes.fromhex(w)) for w in words])
+    if not frames:
+        sys.exit('%s: no frames' % path)
+    return frames
+
+
+def same_run(frame, i):
+    # number of pixels from i on with the colour of pixel i
+    n = 1
+    while (i + n < NUM_LEDS) and (n < RUN_MAX) and (frame[i + n] == frame[i]):
+        n += 1
+    return n
+
+
+def encode_frame(prev, frame):
+    out = []
+    i = 0
+    while i < NUM_LEDS:
+        if frame[i] == prev[i]:
+            n = 1
+            while (i + n < NUM_LEDS) and (n < RUN_MAX) and (frame[i + n] == prev[i + n]):
+                n += 1
+            if i + n < NUM_LEDS:
+                # trailing unchanged pixels need no skip
+                out.append(OP_SKIP | n)
+            i += n
+            continue
+        n = same_run(frame, i)
+        if n > 1:
+            out.append(OP_FILL | n)
+            out.extend(frame[i])
+            i += n
+            continue
+        # literal pixels up to the next unchanged pixel or fill run
+        n = 1
+        while ((i + n < NUM_LEDS) and (n < RUN_MAX) and (frame[i + n] != prev[i + n]) and
+               (same_run(frame, i + n) == 1)):
+            n += 1
+        out.append(OP_LITERAL | n)
+        for c in frame[i:i + n]:
+            out.extend(c)
+        i += n
+    out.append(END_FRAME)
+    return out
+
+
+def main():
+    if len(sys.argv) != 3:
+        sys.exit('usage: clip_compress.py <clip.txt> <array name>')
+    frames = parse(sys.argv[1])
+    prev = [(0, 0, 0)] * NUM_LEDS
+    data = []
+    for frame in frames:
+        data.extend(encode_frame(prev, frame))
+        prev = frame
+    data.append(END_CLIP)
+
+    raw = len(frames) * NUM_LEDS * 3
+    print('// %s, %d frames, %d bytes (%d uncompressed)' %
+          (sys.argv[1].split('/')[-1], len(frames), len(data), raw))
+    print('static const uint8_t %s[] PROGMEM =' % sys.argv[2])
+    print('{')
+    for i in range(0, len(data), 16):
+        print('    ' + ' '.join('0x%02x,' % b for b in data[i:i + 16]))
+    print('};')
+
+
+if __name__ == '__main__':
+    main()
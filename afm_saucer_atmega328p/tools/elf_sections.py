@@ -0,0 +1,17 @@
+#
+# Attack from Mars! RGB saucer - ELF section sizes
+#
+# Shared by the PlatformIO extra scripts mem_report.py and boot_report.py,
+# which add the tools directory to the module path before importing it.
+
+import subprocess
+
+
+def section_sizes(sizetool, elf):
+    sizes = {}
+    out = subprocess.check_output([sizetool, '-A', elf], universal_newlines=True)
+    for line in out.splitlines():
+        fields = line.split()
+        if len(fields) >= 2 and fields[0].startswith('.') and fields[1].isdigit():
+            sizes[fields[0]] = int(fields[1])
+    return sizes
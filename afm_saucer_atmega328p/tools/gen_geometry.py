@@ -0,0 +1,139 @@
+#!/usr/bin/env python3
+#
+# Attack from Mars! RGB saucer - LED geometry table generator
+#
+# Reads the physical LED positions from led_pos.ods (the rows below the
+# 'angle X Y' header, the ring centre from 'X offs' and 'Y offs') and writes
+# src/geometry.c with the polar angle, radius and ring neighbours of every
+# saucer LED, so the effects never need trigonometry at runtime.
+#
+# Also runs as a PlatformIO pre script and regenerates the table whenever the
+# spreadsheet is newer.
+#
+#   gen_geometry.py [led_pos.ods [geometry.c]]
+
+import math
+import os
+import sys
+import xml.etree.ElementTree as ET
+import zipfile
+
+NUM_LEDS = 16
+NEIGHBOUR_MAX = 1.5     # neighbours are at most this many times the LED pitch apart
+GEO_NONE = 0xff
+
+NS = {
+    'table': 'urn:oasis:names:tc:opendocument:xmlns:table:1.0',
+    'office': 'urn:oasis:names:tc:opendocument:xmlns:office:1.0',
+    'text': 'urn:oasis:names:tc:opendocument:xmlns:text:1.0',
+}
+
+
+def paths(project):
+    # the spreadsheet is in the repository root, one level above the project
+    return (os.path.join(os.path.dirname(project), 'led_pos.ods'),
+            os.path.join(project, 'src', 'geometry.c'))
+
+
+def cell_value(cell):
+    v = cell.get('{%s}value' % NS['office'])
+    if v is not None:
+        return v
+    return ''.join(cell.itertext()).strip()
+
+
+def read_rows(path):
+    with zipfile.ZipFile(path) as z:
+        root = ET.fromstring(z.read('content.xml'))
+    rows = []
+    for row in root.iter('{%s}table-row' % NS['table']):
+        cells = []
+        for cell in row:
+            n = int(cell.get('{%s}number-columns-repeated' % NS['table'], '1'))
+            cells += [cell_value(cell)] * min(n, 16)
+        rows.append(cells)
+    return rows
+
+
+def find_value(rows, label):
+    for cells in rows:
+        if label in cells:
+            return float(cells[cells.index(label) + 1])
+    sys.exit('%s not found' % label)
+
+
+def read_positions(path):
+    rows = read_rows(path)
+    cx = find_value(rows, 'X offs')
+    cy = find_value(rows, 'Y offs')
+    pos = None
+    for cells in rows:
+        if pos is None:
+            if 'angle' in cells and 'X' in cells and 'Y' in cells:
+                ix, iy = cells.index('X'), cells.index('Y')
+                pos = []
+            continue
+        try:
+            pos.append((float(cells[ix]) - cx, float(cells[iy]) - cy))
+        except (IndexError, ValueError):
+            # rows without coordinates (the empty slot of the ring)
+            pass
+    if pos is None or len(pos) != NUM_LEDS:
+        sys.exit('%s: expected %d LED positions' % (path, NUM_LEDS))
+    return pos
+
+
+def geometry(pos):
+    # binary angle 0..255 in ring index direction starting at the top (the
+    # sheet uses x = -sin(a) and y = -cos(a)), radius 255 at the outermost LED
+    rmax = max(math.hypot(x, y) for x, y in pos)
+    geo = []
+    for x, y in pos:
+        a = math.degrees(math.atan2(-x, -y)) % 360
+        geo.append([round(a * 256 / 360) & 0xff, round(math.hypot(x, y) * 255 / rmax)])
+
+    # the previous and next LED along the ring, unless there is a gap
+    dist = lambda i, j: math.hypot(pos[i][0] - pos[j][0], pos[i][1] - pos[j][1])
+    pitch = min(dist(i, j) for i in range(NUM_LEDS) for j in range(NUM_LEDS) if i != j)
+    for i in range(NUM_LEDS):
+        for j in ((i - 1) % NUM_LEDS, (i + 1) % NUM_LEDS):
+            geo[i].append(j if dist(i, j) <= pitch * NEIGHBOUR_MAX else GEO_NONE)
+    return geo
+
+
+def banner(header):
+    # the project banner of the hand written header
+    with open(header) as f:
+        text = f.read()
+    return text[:text.index('***/') + 4]
+
+
+def write(geo, out, source):
+    with open(out, 'w') as f:
+        f.write(banner(os.path.join(os.path.dirname(out), 'geometry.h')) + '\n\n')
+        f.write('// Generated from %s by tools/gen_geometry.py, do not edit\n\n' % os.path.basename(source))
+        f.write('#include <avr/pgmspace.h>\n#include "modes.h"\n#include "geometry.h"\n\n\n')
+        f.write('//------------------------------------------------------------------------------\n')
+        f.write('const GEOMETRY_t skGeometry[NUM_LEDS] PROGMEM =\n{\n')
+        f.write('    // angle, radius, prev, next\n')
+        for i, (a, r, p, n) in enumerate(geo):
+            f.write('    { %3d, %3d, %#04x, %#04x },   // LED %d\n' % (a, r, p, n, i))
+        f.write('};\n')
+
+
+def generate(source, out):
+    write(geometry(read_positions(source)), out, source)
+    print('LED geometry: %s -> %s' % (source, out))
+
+
+try:
+    # PlatformIO pre script
+    Import('env')
+    ods, out = paths(env.subst('$PROJECT_DIR'))
+    if (not os.path.exists(out)) or (os.path.getmtime(ods) > os.path.getmtime(out)):
+        generate(ods, out)
+except NameError:
+    if __name__ == '__main__':
+        ods, out = paths(os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+        generate(sys.argv[1] if len(sys.argv) > 1 else ods,
+                 sys.argv[2] if len(sys.argv) > 2 else out)
@@ -0,0 +1,45 @@
+#!/usr/bin/env python3
+#
+# Attack from Mars! RGB saucer - wavetable generator
+#
+# Prints the PROGMEM wavetables used by the animation oscillators in
+# src/waves.c. All waves start at 0 at phase 0 and reach 255 at half the
+# period, like the original triangle bounce.
+#
+#   gen_waves.py > table.txt
+
+import math
+
+SIZE = 256
+
+
+def triangle(i):
+    return min(255, round(i * 2 if i < SIZE // 2 else (SIZE - i) * 2))
+
+
+def sine(i):
+    return round((1 - math.cos(2 * math.pi * i / SIZE)) / 2 * 255)
+
+
+def ease(i):
+    x = triangle(i) / 255
+    return round((x * x * (3 - 2 * x)) * 255)
+
+
+def square(i):
+    return 0 if i < SIZE // 2 else 255
+
+
+def table(name, f):
+    print('    // %s' % name)
+    print('    {')
+    for row in range(0, SIZE, 16):
+        print('        ' + ', '.join('%3d' % f(i) for i in range(row, row + 16)) + ',')
+    print('    },')
+
+
+if __name__ == '__main__':
+    table('WAVE_TRIANGLE', triangle)
+    table('WAVE_SINE', sine)
+    table('WAVE_EASE', ease)
+    table('WAVE_SQUARE', square)
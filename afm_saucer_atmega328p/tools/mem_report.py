@@ -0,0 +1,136 @@
+#
+# Attack from Mars! RGB saucer - memory budget report
+#
+# PlatformIO extra script, prints the flash use and the .data/.bss/.noinit/
+# stack split of the SRAM and the largest static variables after linking. The
+# build fails if the image does not fit the flash or if less than
+# STACK_RESERVE bytes are left for the stack.
+#
+# Flash and SRAM use are compared with the numbers recorded for the
+# environment in size_baseline.txt, and the build fails if either grew by more
+# than its tolerance. After an intended change, record the new numbers:
+#
+#   pio run -e ATmega88PA -t size-baseline
+
+import os
+import subprocess
+import sys
+
+Import('env')
+
+sys.path.insert(0, env.subst(os.path.join('$PROJECT_DIR', 'tools')))
+from elf_sections import section_sizes
+
+STACK_RESERVE = 256     # minimum SRAM left for the stack [bytes]
+TOP_SYMBOLS = 8         # number of largest RAM symbols listed
+FLASH_TOLERANCE = 64    # flash growth over the baseline accepted [bytes]
+SRAM_TOLERANCE = 8      # SRAM growth over the baseline accepted [bytes]
+BASELINE = os.path.join('tools', 'size_baseline.txt')
+
+
+def ram_symbols(nm, elf):
+    syms = []
+    out = subprocess.check_output([nm, '-S', '--size-sort', '-r', elf], universal_newlines=True)
+    for line in out.splitlines():
+        fields = line.split()
+        if len(fields) == 4 and fields[2] in 'bBdD':
+            syms.append((int(fields[1], 16), fields[3]))
+    return syms[:TOP_SYMBOLS]
+
+
+def usage(env, elf):
+    # (flash, sram) used by the image
+    sizes = section_sizes(env.subst('$SIZETOOL'), elf)
+    flash = sizes.get('.text', 0) + sizes.get('.data', 0)
+    sram = sizes.get('.data', 0) + sizes.get('.bss', 0) + sizes.get('.noinit', 0)
+    return flash, sram
+
+
+def read_baseline(path):
+    # {environment: (flash, sram)}
+    baseline = {}
+    if os.path.exists(path):
+        with open(path) as f:
+            for line in f:
+                fields = line.split('#')[0].split()
+                if len(fields) == 3:
+                    baseline[fields[0]] = (int(fields[1]), int(fields[2]))
+    return baseline
+
+
+def write_baseline(path, baseline):
+    with open(path) as f:
+        header = [line for line in f if line.startswith('#')]
+    with open(path, 'w') as f:
+        f.writelines(header)
+        for name in sorted(baseline):
+            f.write('%-24s %6d %6d\n' % ((name,) + baseline[name]))
+
+
+def mem_report(source, target, env):
+    elf = str(target[0])
+    sizetool = env.subst('$SIZETOOL')
+    nm = sizetool.replace('size', 'nm')
+    rom = int(env.BoardConfig().get('upload.maximum_size', 32768))
+    ram = int(env.BoardConfig().get('upload.maximum_ram_size', 2048))
+
+    sizes = section_sizes(sizetool, elf)
+    text = sizes.get('.text', 0)
+    data = sizes.get('.data', 0)
+    bss = sizes.get('.bss', 0)
+    noinit = sizes.get('.noinit', 0)
+    stack = ram - data - bss - noinit
+    failed = False
+
+    print('Flash budget (%d bytes):' % rom)
+    print('  .text    %5d' % text)
+    print('  .data    %5d' % data)
+    print('  free     %5d' % (rom - text - data))
+    print('SRAM budget (%d bytes):' % ram)
+    print('  .data    %5d' % data)
+    print('  .bss     %5d' % bss)
+    print('  .noinit  %5d' % noinit)
+    print('  stack    %5d  (reserve %d)' % (stack, STACK_RESERVE))
+    print('Largest RAM symbols:')
+    for size, name in ram_symbols(nm, elf):
+        print('  %5d  %s' % (size, name))
+
+    name = env.subst('$PIOENV')
+    flash, sram = usage(env, elf)
+    baseline = read_baseline(env.subst(os.path.join('$PROJECT_DIR', BASELINE)))
+    if name in baseline:
+        baseFlash, baseSram = baseline[name]
+        print('Size against the %s baseline:' % name)
+        print('  flash    %+5d  (%d)' % (flash - baseFlash, baseFlash))
+        print('  sram     %+5d  (%d)' % (sram - baseSram, baseSram))
+        if (flash - baseFlash) > FLASH_TOLERANCE:
+            print('Error: flash grew by %d bytes, record the new baseline if intended' % (flash - baseFlash))
+            failed = True
+        if (sram - baseSram) > SRAM_TOLERANCE:
+            print('Error: SRAM grew by %d bytes, record the new baseline if intended' % (sram - baseSram))
+            failed = True
+    else:
+        print('Warning: no size baseline for %s, record it with -t size-baseline' % name)
+
+    if (text + data) > rom:
+        print('Error: the image exceeds the flash by %d bytes' % (text + data - rom))
+        failed = True
+    if stack < STACK_RESERVE:
+        print('Error: only %d bytes left for the stack' % stack)
+        failed = True
+    if failed:
+        env.Exit(1)
+
+
+def size_baseline(source, target, env):
+    path = env.subst(os.path.join('$PROJECT_DIR', BASELINE))
+    name = env.subst('$PIOENV')
+    baseline = read_baseline(path)
+    baseline[name] = usage(env, env.subst('$BUILD_DIR/${PROGNAME}.elf'))
+    write_baseline(path, baseline)
+    print('%s: flash %d, SRAM %d bytes recorded in %s' % ((name,) + baseline[name] + (BASELINE,)))
+
+
+env.AddPostAction('$BUILD_DIR/${PROGNAME}.elf', mem_report)
+env.AddCustomTarget('size-baseline', '$BUILD_DIR/${PROGNAME}.elf', size_baseline,
+                    title='Size baseline', description='Record the flash and SRAM use as size baseline')
@@ -0,0 +1,175 @@
+#!/usr/bin/env python3
+#
+# Attack from Mars! RGB saucer - rendered frame viewer
+#
+# Decodes the frame mirror of a FRAME_MIRROR firmware build (see
+# src/mirror.c) from the serial port or a raw capture file and shows every
+# frame with the lamp state and saucer mode. Bytes outside of valid packets,
+# like the debug statistics, are passed through as text.
+#
+#   mirror_view.py [-p /dev/ttyUSB0] [-w capture.bin]    live view
+#   mirror_view.py -f capture.bin [-t]                   replay a capture
+#
+#   -t      print frames as text in the replay -v format instead of colours
+#
+# Requires pyserial for the live view.
+
+import argparse
+import sys
+
+NUM_PIXELS = 20
+NUM_LEDS = 16
+SYNC = 0xfe
+END = 0xff
+KEY = 0x80
+HEADER = 7                  # sync, seq, flags, lamps, time [bytes]
+TIME_UNIT_US = 64
+TIME_WRAP = 0x10000
+MODE_NAMES = ['BOOT', 'ATTRACT', 'GAMEIDLE', 'ATTACK', 'TEST']
+
+
+class Decoder:
+    def __init__(self, frame_cb, text_cb):
+        self.buf = bytearray()
+        self.frame_cb = frame_cb
+        self.text_cb = text_cb
+        self.pixels = [(0, 0, 0)] * NUM_PIXELS
+        self.synced = False         # a key frame has been seen
+        self.seq = None
+        self.time = 0               # absolute frame time [us]
+        self.last_unit = None
+        self.lost = 0
+        self.bad = 0
+
+    def feed(self, data):
+        self.buf += data
+        while True:
+            ix = self.buf.find(bytes([SYNC]))
+            if ix < 0:
+                self.text(self.buf)
+                self.buf.clear()
+                return
+            if ix:
+                self.text(self.buf[:ix])
+                del self.buf[:ix]
+            n = self.parse()
+            if n is None:
+                # incomplete, wait for more data
+                return
+            if n == 0:
+                # no valid packet at this sync byte
+                self.bad += 1
+                self.text(self.buf[:1])
+                del self.buf[:1]
+            else:
+                del self.buf[:n]
+
+    def text(self, data):
+        if data:
+            self.text_cb(bytes(data))
+
+    def parse(self):
+        # returns the packet length, 0 if invalid, None if incomplete
+        b = self.buf
+        if len(b) < HEADER:
+            return None
+        pos = HEADER
+        changes = []
+        while True:
+            if len(b) < pos + 1:
+                return None
+            ix = b[pos]
+            if ix == END:
+                break
+            if (ix >= NUM_PIXELS) or (len(changes) >= NUM_PIXELS):
+                return 0
+            if len(b) < pos + 4:
+                return None
+            changes.append((ix, tuple(b[pos + 1:pos + 4])))
+            pos += 4
+        if len(b) < pos + 2:
+            return None
+        if (sum(b[1:pos + 1]) & 0xff) != b[pos + 1]:
+            return 0
+        self.packet(b[1], b[2], b[3] | (b[4] << 8), b[5] | (b[6] << 8), changes)
+        return pos + 2
+
+    def packet(self, seq, flags, lamps, unit, changes):
+        if (self.seq is not None) and (seq != ((self.seq + 1) & 0xff)):
+            # the host missed changes, wait for the next key frame
+            self.lost += ((seq - self.seq - 1) & 0xff)
+            self.synced = False
+        self.seq = seq
+        if self.last_unit is not None:
+            self.time += ((unit - self.last_unit) % TIME_WRAP) * TIME_UNIT_US
+        self.last_unit = unit
+        if flags & KEY:
+            self.synced = True
+        for ix, rgb in changes:
+            self.pixels[ix] = rgb
+        if self.synced:
+            self.frame_cb(self.time, flags & ~KEY, lamps, self.pixels)
+
+
+def mode_name(mode):
+    return MODE_NAMES[mode] if mode < len(MODE_NAMES) else '-'
+
+
+last_mode = None
+
+
+def show_text(t, mode, lamps, pixels):
+    global last_mode
+    if mode != last_mode:
+        print('%10.3fs mode %s' % (t / 1e6, mode_name(mode)))
+        last_mode = mode
+    print('%10.3fs %04x %s' % (t / 1e6, lamps, ' '.join('%02x%02x%02x' % p for p in pixels)))
+
+
+def show_colour(t, mode, lamps, pixels):
+    # saucer LEDs, then the flashers, then the lamps (filled when on)
+    blocks = ''.join('\x1b[48;2;%d;%d;%dm  ' % p for p in pixels[:NUM_LEDS])
+    flashers = ''.join('\x1b[48;2;%d;%d;%dm  ' % p for p in pixels[NUM_LEDS:])
+    lamp_str = ''.join('o' if not (lamps & (1 << i)) else '.' for i in range(NUM_LEDS))
+    sys.stdout.write('\r%9.3fs %s\x1b[0m %s\x1b[0m  %s  %-8s' % (t / 1e6, blocks, flashers, lamp_str, mode_name(mode)))
+    sys.stdout.flush()
+
+
+def show_passthrough(data):
+    sys.stderr.write(data.decode('ascii', 'replace'))
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Show the rendered saucer frames')
+    parser.add_argument('-p', '--port', default='/dev/ttyUSB0', help='serial port')
+    parser.add_argument('-b', '--baud', type=int, default=115200, help='baud rate')
+    parser.add_argument('-f', '--file', help='decode a raw capture instead of the serial port')
+    parser.add_argument('-w', '--write', help='also write the raw stream to this file')
+    parser.add_argument('-t', '--text', action='store_true', help='print frames as text')
+    args = parser.parse_args()
+
+    dec = Decoder(show_text if args.text else show_colour, show_passthrough)
+    if args.file:
+        with open(args.file, 'rb') as f:
+            dec.feed(f.read())
+    else:
+        import serial
+        with serial.Serial(args.port, args.baud, timeout=0.1) as port:
+            out = open(args.write, 'wb') if args.write else None
+            try:
+                while True:
+                    data = port.read(256)
+                    if out:
+                        out.write(data)
+                    dec.feed(data)
+            except KeyboardInterrupt:
+                pass
+            if out:
+                out.close()
+    if not args.text:
+        print()
+    print('%d packets lost, %d bad packets' % (dec.lost, dec.bad), file=sys.stderr)
+
+
+if __name__ == '__main__':
+    main()
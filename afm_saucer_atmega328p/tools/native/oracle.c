@@ -0,0 +1,429 @@
+/***********************************************************************
+ *    _   _   _             _     __                                           
+ *   /_\ | |_| |_ __ _  ___| | __/ _|_ __ ___  _ __ ___   /\/\   __ _ _ __ ___ 
+ *  //_\\| __| __/ _` |/ __| |/ / |_| '__/ _ \| '_ ` _ \ /    \ / _` | '__/ __|
+ * /  _  \ |_| || (_| | (__|   <|  _| | | (_) | | | | | / /\/\ \ (_| | |  \__ \
+ * \_/ \_/\__|\__\__,_|\___|_|\_\_| |_|  \___/|_| |_| |_\/    \/\__,_|_|  |___/
+ *
+ *                              ____ ____ ___ 
+ *                              |--< |__, |==]
+ *
+ *                      ____ ____ _  _ ____ ____ ____
+ *                      ==== |--| |__| |___ |=== |--<
+ *
+ *  Copyright (c) 2022 bitfield labs
+ * 
+ ***********************************************************************
+ *  This file is part of the Attack from Mars! RGB saucer project:
+ *  https://github.com/bitfieldlabs/afm_saucer
+ *
+ *  The AfM RGB saucer is free software: you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public License as
+ *  published by the Free Software Foundation, either version 3 of the
+ *  License, or (at your option) any later version.
+ *
+ *  AfM RGB saucer is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with afterglow.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ ***********************************************************************/
+
+// Differential oracle for the rendering kernels
+//
+// Compares the optimised fixed point kernels of the firmware against plain
+// double precision reference models over their full input domain and checks
+// the differences against the error bounds below. Any change to a kernel
+// must keep within its bounds, or come with new bounds and the reasoning
+// for them (tools/README.md).
+//
+//   oracle         exits with 1 if any bound is exceeded
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+#include <math.h>
+#include "modes.h"
+#include "layers.h"
+#include "utils.h"
+#include "patterns.h"
+
+
+//------------------------------------------------------------------------------
+// definitions
+
+// error bounds, maximum and mean absolute difference [8 bit colour steps]
+#define HSV_MAX_ERR 3.0         // S and V scaled by 1/256 instead of 1/255, truncated
+#define HSV_MEAN_ERR 0.6
+#define BLEND_MAX_ERR 1.0       // truncated instead of rounded
+#define BLEND_MEAN_ERR 0.5
+#define SCALE_MAX_ERR 1.0       // truncated instead of rounded
+#define SCALE_MEAN_ERR 0.5
+#define WAVE_MAX_ERR 1.5        // 8 bit table entries, linear interpolation
+#define WAVE_MEAN_ERR 0.5
+#define COLOR_MAX_ERR 8.0       // 8 bit hue, one hue step moves a channel by 6
+#define COLOR_MEAN_ERR 1.0
+
+#define COLOR_SWITCH_FRAMES 400     // frames allowed for a saucer mode switch
+#define COLOR_EVAL_FRAMES 1024      // frames compared per saucer mode
+#define COLOR_BULB_STEPS 8          // bulb brightnesses compared per frame
+
+
+//------------------------------------------------------------------------------
+// global variables
+
+volatile uint8_t PIND = 0xff;
+volatile uint16_t TCNT1 = 0;
+
+typedef struct ERROR_STATS_s
+{
+    double max;         // largest absolute difference
+    double sum;         // sum of all absolute differences
+    uint64_t num;       // number of compared values
+} ERROR_STATS_t;
+
+static bool sFailed = false;
+
+// not part of the modes.c interface, only used here
+bool bgVisible(const FRAME_t *f);
+void renderBackground(FRAME_t *f, uint8_t blend);
+void renderForeground(FRAME_t *f, uint8_t blend);
+
+
+//------------------------------------------------------------------------------
+void sendPixel(uint8_t r, uint8_t g, uint8_t b, bool firstString)
+{
+}
+
+//------------------------------------------------------------------------------
+uint16_t timerTicks()
+{
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+static void addError(ERROR_STATS_t *e, double fw, double ref)
+{
+    double d = fabs(fw - ref);
+    if (d > e->max)
+    {
+        e->max = d;
+    }
+    e->sum += d;
+    e->num++;
+}
+
+//------------------------------------------------------------------------------
+static void report(const char *name, const ERROR_STATS_t *e, double maxErr, double meanErr)
+{
+    double mean = e->num ? (e->sum / e->num) : 0.0;
+    bool ok = ((e->max <= maxErr) && (mean <= meanErr));
+    printf("%-10s %12llu values  max %6.3f (bound %.1f)  mean %6.3f (bound %.1f)  %s\n",
+           name, (unsigned long long)e->num, e->max, maxErr, mean, meanErr, ok ? "ok" : "FAILED");
+    if (!ok)
+    {
+        sFailed = true;
+    }
+}
+
+//------------------------------------------------------------------------------
+static void refHSV(double h, double s, double v, double rgb[3])
+{
+    // textbook HSV to RGB, h in [0, 1), s and v in [0, 1], rgb in 0..255
+    double hh = (h * 6.0);
+    int seg = (int)hh;
+    double f = (hh - seg);
+    double p = v * (1.0 - s);
+    double q = v * (1.0 - (s * f));
+    double t = v * (1.0 - (s * (1.0 - f)));
+    double c[6][3] = { { v, t, p }, { q, v, p }, { p, v, t }, { p, q, v }, { t, p, v }, { v, p, q } };
+    for (int i=0; i<3; i++)
+    {
+        rgb[i] = (c[seg % 6][i] * 255.0);
+    }
+}
+
+//------------------------------------------------------------------------------
+static void checkHSV()
+{
+    // all hue, saturation and value combinations
+    ERROR_STATS_t e = { 0 };
+    for (int h=0; h<256; h++)
+    {
+        for (int s=0; s<256; s++)
+        {
+            for (int v=0; v<256; v++)
+            {
+                uint8_t fw[3];
+                double ref[3];
+                hsv2rgb(h, s, v, &fw[0], &fw[1], &fw[2]);
+                refHSV(h / 256.0, s / 255.0, v / 255.0, ref);
+                for (int i=0; i<3; i++)
+                {
+                    addError(&e, fw[i], ref[i]);
+                }
+            }
+        }
+    }
+    report("hsv2rgb", &e, HSV_MAX_ERR, HSV_MEAN_ERR);
+}
+
+//------------------------------------------------------------------------------
+static void checkBlend()
+{
+    // all colour pairs and blend ratios
+    ERROR_STATS_t e = { 0 };
+    for (int a=0; a<256; a++)
+    {
+        for (int b=0; b<256; b++)
+        {
+            for (int x=0; x<256; x++)
+            {
+                addError(&e, blend8(a, b, x), a + ((b - a) * x / 256.0));
+            }
+        }
+    }
+    report("blend8", &e, BLEND_MAX_ERR, BLEND_MEAN_ERR);
+}
+
+//------------------------------------------------------------------------------
+static void checkScale()
+{
+    ERROR_STATS_t e = { 0 };
+    for (int v=0; v<256; v++)
+    {
+        for (int s=0; s<256; s++)
+        {
+            addError(&e, scale8(v, s), v * s / 256.0);
+            addError(&e, qadd8(v, s), (v + s > 255) ? 255 : (v + s));
+        }
+    }
+    report("scale8", &e, SCALE_MAX_ERR, SCALE_MEAN_ERR);
+}
+
+//------------------------------------------------------------------------------
+static void checkBitsSet()
+{
+    // all lamp states, no error allowed
+    ERROR_STATS_t e = { 0 };
+    for (uint32_t v=0; v<0x10000; v++)
+    {
+        addError(&e, bitsSet(v), __builtin_popcount(v));
+    }
+    report("bitsSet", &e, 0.0, 0.0);
+}
+
+//------------------------------------------------------------------------------
+static double refWave(uint8_t wave, double p)
+{
+    // the continuous waveforms of tools/gen_waves.py, p in [0, 1), 0..1
+    double tri = (p < 0.5) ? (2.0 * p) : (2.0 - (2.0 * p));
+    switch (wave)
+    {
+#ifdef FEATURE_WAVETABLES
+        case WAVE_SINE: return ((1.0 - cos(2.0 * M_PI * p)) / 2.0);
+#else
+        // computed waves, the ease curve stands in for the sine (src/waves.c)
+        case WAVE_SINE: return (tri * tri * (3.0 - (2.0 * tri)));
+#endif
+        case WAVE_EASE: return (tri * tri * (3.0 - (2.0 * tri)));
+        case WAVE_SQUARE:
+            // the edges take one table step
+            if ((p >= (0.5 - (1.0 / 256))) && (p < 0.5))
+            {
+                return ((p - (0.5 - (1.0 / 256))) * 256.0);
+            }
+            if (p >= (1.0 - (1.0 / 256)))
+            {
+                return ((1.0 - p) * 256.0);
+            }
+            return (p < 0.5) ? 0.0 : 1.0;
+        default: return tri;
+    }
+}
+
+//------------------------------------------------------------------------------
+static void checkWaves()
+{
+    // all phases of all waveforms, in 8 bit steps
+    ERROR_STATS_t e = { 0 };
+    for (uint8_t w=0; w<WAVE_NUM; w++)
+    {
+        for (uint32_t p=0; p<0x10000; p++)
+        {
+            addError(&e, waveSample(w, p) / 257.0, refWave(w, p / 65536.0) * 255.0);
+        }
+    }
+    report("waveSample", &e, WAVE_MAX_ERR, WAVE_MEAN_ERR);
+}
+
+//------------------------------------------------------------------------------
+static double refOscillator(uint8_t wave, uint16_t start, uint16_t end, int16_t speed, int16_t ofs,
+                            uint32_t frame, uint8_t ix)
+{
+    // The original animation: every LED starts ofs further up the range and
+    // moves by speed per frame, bouncing between start and end. Unfolded
+    // that is a position u on a waveform with a period of twice the range.
+    if (end <= start)
+    {
+        return start;
+    }
+    double range = (end - start);
+    double u = ((double)ofs * ix) + ((double)speed * frame);
+    double p = fmod(u / (2.0 * range), 1.0);
+    if (p < 0.0)
+    {
+        p += 1.0;
+    }
+    return (start + (range * refWave(wave, p)));
+}
+
+//------------------------------------------------------------------------------
+static void refLayer(const LED_MODE_t *m, uint32_t frame, uint8_t ix, double rgb[3])
+{
+    double h = refOscillator(WAVE_TRIANGLE, m->startH, m->endH, m->speedH, m->ofsH, frame, ix);
+    double v = refOscillator(m->wave, m->startV, m->endV, m->speedV, m->ofsV, frame, ix);
+    refHSV(fmod(h / (256.0 * VSCALE), 1.0), 1.0, (v / (255.0 * VSCALE)), rgb);
+}
+
+//------------------------------------------------------------------------------
+static void refColor(uint8_t cfg, uint8_t mode, uint32_t frame, uint32_t frameCnt,
+                     uint8_t pos, uint8_t ag, double rgb[3])
+{
+    const LED_MODE_t *fg = skColorPatterns[cfg].fgLEDModes[mode];
+    const LED_MODE_t *bg = skColorPatterns[cfg].bgLEDModes[mode];
+
+    // the background rotates by one LED every animSpeed frames
+    int steps = bg->animSpeed ? (int)(frame / bg->animSpeed) : 0;
+    uint8_t bgPos = ((pos + (bg->animDir ? steps : -steps)) & (NUM_LEDS - 1));
+
+    // the background is black while blinking off, afterglow blends over it
+    double b[3] = { 0.0, 0.0, 0.0 };
+    if (!(bg->blinkInt && ((frameCnt >> bg->blinkInt) & 0x01)))
+    {
+        refLayer(bg, frame, bgPos, b);
+    }
+
+    if (ag == AG_FULL)
+    {
+        refLayer(fg, frame, pos, rgb);
+    }
+    else if (ag)
+    {
+        double f[3];
+        refLayer(fg, frame, pos, f);
+        double ratio = ag / 256.0;
+        for (int i=0; i<3; i++)
+        {
+            rgb[i] = b[i] + ((f[i] - b[i]) * ratio);
+        }
+    }
+    else
+    {
+        for (int i=0; i<3; i++)
+        {
+            rgb[i] = b[i];
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+static void checkColors()
+{
+    // every color pattern in every saucer mode, all LEDs at all afterglow
+    // steps or a range of bulb brightnesses, driven through the regular
+    // interface like the main loop does
+    static const uint16_t skLamps[SM_NUM] = { 0x0000, 0xcccc, 0xffff, 0xf0f0, 0xfffe };  // active low
+    ERROR_STATS_t e = { 0 };
+    uint32_t frameCnt = 0;
+    uint32_t frame = 0;
+    uint8_t lastMode = getMode();
+    for (uint8_t cfg=1; cfg<NUM_COLOR_PATTERN; cfg++)
+    {
+        setConfig(cfg);
+        frame = 0;
+        for (uint8_t mode=0; mode<SM_NUM; mode++)
+        {
+            uint32_t n = 0;
+            uint32_t eval = 0;
+            while ((eval < COLOR_EVAL_FRAMES) && (n < (COLOR_SWITCH_FRAMES + COLOR_EVAL_FRAMES)))
+            {
+                updateLEDState(skLamps[mode]);
+                if (getMode() != lastMode)
+                {
+                    // the animations restart with the new mode
+                    lastMode = getMode();
+                    frame = 0;
+                }
+                updateLEDs(1);
+                frame++;
+                frameCnt++;
+                n++;
+                if (getMode() != mode)
+                {
+                    continue;
+                }
+
+                const LED_MODE_t *fg = skColorPatterns[cfg].fgLEDModes[mode];
+                bool clip = (skColorPatterns[cfg].bgClips[mode] != NULL);
+                uint8_t steps = fg->bulb ? COLOR_BULB_STEPS : fg->afterglow;
+                for (uint8_t step=0; step<=steps; step++)
+                {
+                    if (clip && (step < steps))
+                    {
+                        // the background comes from a clip
+                        continue;
+                    }
+                    // background and foreground layers with all LEDs at
+                    // the same afterglow blend
+                    uint8_t ag = (step == steps) ? AG_FULL : (step * (256 / steps));
+                    if (step == 0)
+                    {
+                        ag = 0;
+                    }
+                    FRAME_t f;
+                    memset(&f, 0, sizeof(f));
+                    memset(f.ag, ag, sizeof(f.ag));
+                    f.lit = (ag ? NUM_LEDS : 0);
+                    if (bgVisible(&f))
+                    {
+                        renderBackground(&f, BLEND_NORMAL);
+                    }
+                    renderForeground(&f, BLEND_NORMAL);
+                    for (uint8_t pos=0; pos<NUM_LEDS; pos++)
+                    {
+                        double ref[3];
+                        refColor(cfg, mode, frame, frameCnt, pos, ag, ref);
+                        addError(&e, f.r[pos], ref[0]);
+                        addError(&e, f.g[pos], ref[1]);
+                        addError(&e, f.b[pos], ref[2]);
+                    }
+                }
+                eval++;
+            }
+            if (eval < COLOR_EVAL_FRAMES)
+            {
+                printf("color pattern %u never reached saucer mode %u\n", cfg, mode);
+                sFailed = true;
+            }
+        }
+    }
+    report("layers", &e, COLOR_MAX_ERR, COLOR_MEAN_ERR);
+}
+
+//------------------------------------------------------------------------------
+int main()
+{
+    checkBitsSet();
+    checkBlend();
+    checkScale();
+    checkHSV();
+    checkWaves();
+    checkColors();
+    return sFailed ? 1 : 0;
+}
@@ -0,0 +1,324 @@
+/***********************************************************************
+ *    _   _   _             _     __                                           
+ *   /_\ | |_| |_ __ _  ___| | __/ _|_ __ ___  _ __ ___   /\/\   __ _ _ __ ___ 
+ *  //_\\| __| __/ _` |/ __| |/ / |_| '__/ _ \| '_ ` _ \ /    \ / _` | '__/ __|
+ * /  _  \ |_| || (_| | (__|   <|  _| | | (_) | | | | | / /\/\ \ (_| | |  \__ \
+ * \_/ \_/\__|\__\__,_|\___|_|\_\_| |_|  \___/|_| |_| |_\/    \/\__,_|_|  |___/
+ *
+ *                              ____ ____ ___ 
+ *                              |--< |__, |==]
+ *
+ *                      ____ ____ _  _ ____ ____ ____
+ *                      ==== |--| |__| |___ |=== |--<
+ *
+ *  Copyright (c) 2022 bitfield labs
+ * 
+ ***********************************************************************
+ *  This file is part of the Attack from Mars! RGB saucer project:
+ *  https://github.com/bitfieldlabs/afm_saucer
+ *
+ *  The AfM RGB saucer is free software: you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public License as
+ *  published by the Free Software Foundation, either version 3 of the
+ *  License, or (at your option) any later version.
+ *
+ *  AfM RGB saucer is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with afterglow.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ ***********************************************************************/
+
+// Native trace replayer
+//
+// Feeds a trace recorded with the TRACE_RECORDER firmware build (the UART
+// output of one or more 'd' dump commands) into the firmware's rendering code
+// at full host speed and reports what the saucer would have shown.
+//
+//   replay [-v] <trace file>
+//
+//   -v     print every rendered frame
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <time.h>
+#include "modes.h"
+#include "led.h"
+#include "timer.h"
+#include "trace.h"
+#include "events.h"
+#include "chase.h"
+
+
+//------------------------------------------------------------------------------
+// definitions
+
+#define FRAME_US 20000                      // firmware frame interval [us]
+#define PASS_MIN_US 1000                    // shortest interval between passthrough renders, PASS_MIN_TICKS in main.c [us]
+#define MAX_RECORDS 1000000
+#define TRACE_UNIT_US (TIMER_TICK_US << TRACE_TIME_SHIFT)
+
+
+//------------------------------------------------------------------------------
+// global variables
+
+volatile uint8_t PIND = 0xff;
+volatile uint16_t TCNT1 = 0;
+
+typedef struct REPLAY_RECORD_s
+{
+    uint64_t time;      // absolute time [us]
+    uint8_t type;       // EVENT_TYPE_t
+    uint16_t data;      // record data
+} REPLAY_RECORD_t;
+
+static REPLAY_RECORD_t *sRecords = NULL;
+static size_t sNumRecords = 0;
+static uint8_t sPixels[NUM_PIXELS][3];      // last rendered frame
+static uint8_t sPixelIx = 0;
+static uint8_t sPrevPixels[NUM_PIXELS][3];  // frame rendered before
+static uint64_t sLampOnTime[NUM_LEDS];      // time each lamp turned on, 0 once it is lit [us]
+static uint64_t sLatencySum = 0;
+static uint64_t sLatencyMax = 0;
+static uint64_t sLatencyNum = 0;
+
+
+//------------------------------------------------------------------------------
+void sendPixel(uint8_t r, uint8_t g, uint8_t b, bool firstString)
+{
+    // the firmware sends 16 saucer LEDs first, then the 4 flashers
+    if (sPixelIx < NUM_PIXELS)
+    {
+        sPixels[sPixelIx][0] = r;
+        sPixels[sPixelIx][1] = g;
+        sPixels[sPixelIx][2] = b;
+        sPixelIx++;
+    }
+}
+
+//------------------------------------------------------------------------------
+uint16_t timerTicks()
+{
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+static bool loadTrace(const char *fileName)
+{
+    FILE *f = fopen(fileName, "r");
+    if (!f)
+    {
+        perror(fileName);
+        return false;
+    }
+
+    sRecords = malloc(MAX_RECORDS * sizeof(REPLAY_RECORD_t));
+    char line[128];
+    uint64_t now = 0;
+    int lastUnit = -1;
+    unsigned int lost = 0;
+    while (fgets(line, sizeof(line), f) && (sNumRecords < MAX_RECORDS))
+    {
+        unsigned int type, unit, data;
+        if (sscanf(line, "END %x", &data) == 1)
+        {
+            // the firmware reports the total number of lost events
+            lost = data;
+        }
+        else if (sscanf(line, "%1u %4x %4x", &type, &unit, &data) == 3)
+        {
+            // the time stamps wrap every 1.05s, the firmware records at
+            // least every 240ms (TRACE_KEEPALIVE in main.c)
+            if (lastUnit >= 0)
+            {
+                now += ((unit - lastUnit) & TRACE_TIME_MASK) * TRACE_UNIT_US;
+            }
+            lastUnit = unit;
+            REPLAY_RECORD_t *rec = &sRecords[sNumRecords++];
+            rec->time = now;
+            rec->type = type;
+            rec->data = data;
+        }
+    }
+    fclose(f);
+    if (lost)
+    {
+        fprintf(stderr, "warning: %u events were lost during recording\n", lost);
+    }
+    return (sNumRecords > 0);
+}
+
+//------------------------------------------------------------------------------
+static void measureLatency(uint64_t t)
+{
+    // lamp to light latency, measured to the first frame changing the LED
+    for (uint8_t i=0; i<NUM_LEDS; i++)
+    {
+        if (sLampOnTime[i] && memcmp(sPixels[i], sPrevPixels[i], 3))
+        {
+            uint64_t l = (t - sLampOnTime[i]);
+            sLatencySum += l;
+            sLatencyNum++;
+            if (l > sLatencyMax)
+            {
+                sLatencyMax = l;
+            }
+            sLampOnTime[i] = 0;
+        }
+    }
+    memcpy(sPrevPixels, sPixels, sizeof(sPixels));
+}
+
+//------------------------------------------------------------------------------
+int main(int argc, char *argv[])
+{
+    static const char *skModeNames[] = { "BOOT", "ATTRACT", "GAMEIDLE", "ATTACK", "TEST", "-" };
+    bool verbose = false;
+    const char *fileName = NULL;
+    for (int i=1; i<argc; i++)
+    {
+        if (strcmp(argv[i], "-v") == 0)
+        {
+            verbose = true;
+        }
+        else
+        {
+            fileName = argv[i];
+        }
+    }
+    if (!fileName)
+    {
+        fprintf(stderr, "usage: %s [-v] <trace file>\n", argv[0]);
+        return 1;
+    }
+    if (!loadTrace(fileName))
+    {
+        fprintf(stderr, "no trace records found\n");
+        return 1;
+    }
+
+    uint16_t ledState = 0xffff;
+    uint8_t lastMode = 0xff;
+    uint32_t frames = 0;
+    uint32_t rendered = 0;
+    uint32_t passed = 0;
+    uint64_t passTime = 0;
+    uint8_t interval = 1;
+    uint8_t steps = 0;
+    size_t rix = 0;
+    clock_t startClock = clock();
+
+    // run the frames in virtual time
+    for (uint64_t t=0; rix<sNumRecords; t+=FRAME_US)
+    {
+        // apply all records up to now
+        uint8_t events = 0;
+        while ((rix < sNumRecords) && (sRecords[rix].time <= t))
+        {
+            const REPLAY_RECORD_t *rec = &sRecords[rix++];
+            if ((rec->type != EV_LAMPS) || (rec->data != ledState))
+            {
+                // the firmware only queues changed lamp frames, the trace
+                // also has the keepalive records
+                events++;
+            }
+            switch (rec->type)
+            {
+                case EV_LAMPS:
+                {
+                    // remember when each lamp turned on (lamps are active low)
+                    uint16_t on = (ledState & ~rec->data);
+                    for (uint8_t i=0; i<NUM_LEDS; i++)
+                    {
+                        if (on & (1 << i))
+                        {
+                            sLampOnTime[i] = rec->time;
+                        }
+                    }
+                    bool changed = (rec->data != ledState);
+                    ledState = rec->data;
+
+                    // the passthrough shows changed lamp frames between
+                    // two frames right away
+                    if (changed && lampPassthrough() && ((rec->time - passTime) >= PASS_MIN_US))
+                    {
+                        sPixelIx = 0;
+                        showLamps(ledState);
+                        measureLatency(rec->time);
+                        passTime = rec->time;
+                        passed++;
+                    }
+                }
+                break;
+                case EV_FLASH: triggerFlasher(0); break;
+                case EV_SHAKER: triggerShaker(0); break;
+                case EV_CONFIG: setConfig(rec->data); break;
+                default: break;
+            }
+        }
+
+        // one firmware frame, rendered at the rate the firmware chooses
+        updateLEDState(ledState);
+        frames++;
+        steps++;
+        if (!events && (steps < interval))
+        {
+            continue;
+        }
+        sPixelIx = 0;
+        updateLEDs(steps);
+        interval = frameInterval(events);
+        steps = 0;
+        rendered++;
+
+        measureLatency(t);
+
+        uint8_t mode = getMode();
+        if (mode != lastMode)
+        {
+            printf("%10.3fs mode %s\n", t / 1e6, skModeNames[(mode < 5) ? mode : 5]);
+            lastMode = mode;
+        }
+        if (verbose)
+        {
+            printf("%10.3fs %04x", t / 1e6, ledState);
+            for (uint8_t i=0; i<NUM_PIXELS; i++)
+            {
+                printf(" %02x%02x%02x", sPixels[i][0], sPixels[i][1], sPixels[i][2]);
+            }
+            printf("\n");
+        }
+    }
+
+    double secs = (double)(clock() - startClock) / CLOCKS_PER_SEC;
+    printf("%zu records, %u frames (%.1fs) replayed in %.3fs\n",
+           sNumRecords, frames, frames * (FRAME_US / 1e6), secs);
+    printf("adaptive frame rate: %u frames rendered (%u%%)\n",
+           rendered, frames ? (unsigned int)((rendered * 100ULL) / frames) : 0);
+    if (passed)
+    {
+        printf("lamp passthrough: %u lamp frames shown between frames\n", passed);
+    }
+    if (sLatencyNum)
+    {
+        printf("lamp to light latency: avg %.1fms, max %.1fms (%llu samples)\n",
+               sLatencySum / 1e3 / sLatencyNum, sLatencyMax / 1e3, (unsigned long long)sLatencyNum);
+    }
+    uint16_t peak, avg;
+    uint32_t limited;
+    getPowerStats(&peak, &avg, &limited);
+    printf("estimated LED current: peak %umA, average %umA, %u frames limited\n",
+           peak, avg, (unsigned int)limited);
+    uint32_t hits, misses;
+    getChaseStats(&hits, &misses);
+    printf("chase prediction: %u hits, %u misses (%u%% hit rate)\n",
+           (unsigned int)hits, (unsigned int)misses,
+           (hits + misses) ? (unsigned int)((hits * 100) / (hits + misses)) : 0);
+    free(sRecords);
+    return 0;
+}
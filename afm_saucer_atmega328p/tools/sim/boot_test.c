@@ -0,0 +1,398 @@
+/***********************************************************************
+ *    _   _   _             _     __                                           
+ *   /_\ | |_| |_ __ _  ___| | __/ _|_ __ ___  _ __ ___   /\/\   __ _ _ __ ___ 
+ *  //_\\| __| __/ _` |/ __| |/ / |_| '__/ _ \| '_ ` _ \ /    \ / _` | '__/ __|
+ * /  _  \ |_| || (_| | (__|   <|  _| | | (_) | | | | | / /\/\ \ (_| | |  \__ \
+ * \_/ \_/\__|\__\__,_|\___|_|\_\_| |_|  \___/|_| |_| |_\/    \/\__,_|_|  |___/
+ *
+ *                              ____ ____ ___ 
+ *                              |--< |__, |==]
+ *
+ *                      ____ ____ _  _ ____ ____ ____
+ *                      ==== |--| |__| |___ |=== |--<
+ *
+ *  Copyright (c) 2022 bitfield labs
+ * 
+ ***********************************************************************
+ *  This file is part of the Attack from Mars! RGB saucer project:
+ *  https://github.com/bitfieldlabs/afm_saucer
+ *
+ *  The AfM RGB saucer is free software: you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public License as
+ *  published by the Free Software Foundation, either version 3 of the
+ *  License, or (at your option) any later version.
+ *
+ *  AfM RGB saucer is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with afterglow.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ ***********************************************************************/
+
+// Serial bootloader test for simavr
+//
+// Runs the ATmega328P_boot bootloader in simavr on a blank flash and plays
+// the host side of an upload, as written by boot_upload.py --dump, on the
+// USART. Bytes are paced like a 115200 baud line and every command waits for
+// its reply like the upload tool does. The test checks:
+//
+//   upload    a corrupted block is rejected, a block sent again after a lost
+//             acknowledge is acknowledged but not written twice, the image is
+//             written and started
+//   restart   after a reset the image is verified and started without a host
+//   badcrc    an image with a wrong CRC is refused and stays refused after reset
+//
+//   boot_test <bootloader.elf> <stream.bin>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include "sim_avr.h"
+#include "sim_elf.h"
+#include "sim_irq.h"
+#include "sim_cycle_timers.h"
+#include "avr_uart.h"
+
+
+//------------------------------------------------------------------------------
+// definitions
+
+#define MCU_NAME "atmega328p"
+#define MCU_FREQ 16000000UL
+
+#define BOOT_START 0x7800               // boot section start [byte address]
+#define BYTE_US 87                      // byte time at 115200 baud [us]
+#define SYNC_INTERVAL_MS 20             // upload request interval [ms]
+#define SYNC_TIMEOUT_MS 2000            // time for the bootloader to answer [ms]
+#define REPLY_TIMEOUT_MS 1000           // command reply timeout [ms]
+#define START_TIMEOUT_MS 1000           // time for starting the application after reset [ms]
+#define MAX_COMMANDS 512                // commands per stream
+
+#define US_TO_CYCLES(us) ((avr_cycle_count_t)(us) * (MCU_FREQ / 1000000UL))
+
+typedef struct COMMAND_s
+{
+    const uint8_t *data;
+    uint32_t len;
+} COMMAND_t;
+
+typedef struct BOOTTEST_s
+{
+    avr_t *avr;
+    avr_irq_t *rx;          // USART input of the bootloader
+    const uint8_t *cmd;     // command being sent
+    uint32_t len;           // command length [bytes]
+    uint32_t pos;           // next byte of the command
+    uint8_t reply[2];       // bytes sent by the bootloader since the command
+    uint8_t replyLen;       // number of bytes in reply
+    uint8_t replyWant;      // reply length the command waits for
+    COMMAND_t cmds[MAX_COMMANDS];   // upload commands without the request
+    uint32_t numCmds;
+    uint16_t length;        // image length from the header
+    uint16_t crc;           // image CRC from the header
+} BOOTTEST_t;
+
+
+//------------------------------------------------------------------------------
+static uint16_t crcXmodem(const uint8_t *data, uint32_t len)
+{
+    uint16_t crc = 0;
+    for (uint32_t i=0; i<len; i++)
+    {
+        crc ^= ((uint16_t)data[i] << 8);
+        for (uint8_t b=0; b<8; b++)
+        {
+            crc = (crc & 0x8000) ? ((crc << 1) ^ 0x1021) : (crc << 1);
+        }
+    }
+    return crc;
+}
+
+//------------------------------------------------------------------------------
+static bool parse(BOOTTEST_t *s, const uint8_t *stream, uint32_t size)
+{
+    // 'U', then the header, the data blocks and the finish command
+    uint32_t i = 1;
+    while (i < size)
+    {
+        uint32_t len;
+        switch (stream[i])
+        {
+            case 'H': len = 5; break;
+            case 'D': len = (i + 2 < size) ? (5u + stream[i + 2]) : size; break;
+            case 'F': len = 1; break;
+            default: return false;
+        }
+        if ((i + len > size) || (s->numCmds >= MAX_COMMANDS))
+        {
+            return false;
+        }
+        s->cmds[s->numCmds].data = &stream[i];
+        s->cmds[s->numCmds].len = len;
+        s->numCmds++;
+        i += len;
+    }
+    if ((s->numCmds < 2) || (s->cmds[0].data[0] != 'H'))
+    {
+        return false;
+    }
+    s->length = s->cmds[0].data[1] | (s->cmds[0].data[2] << 8);
+    s->crc = s->cmds[0].data[3] | (s->cmds[0].data[4] << 8);
+    return true;
+}
+
+//------------------------------------------------------------------------------
+static avr_cycle_count_t sendByte(avr_t *avr, avr_cycle_count_t when, void *param)
+{
+    BOOTTEST_t *s = (BOOTTEST_t*)param;
+    avr_raise_irq(s->rx, s->cmd[s->pos++]);
+    return (s->pos < s->len) ? (when + US_TO_CYCLES(BYTE_US)) : 0;
+}
+
+//------------------------------------------------------------------------------
+static void replyByte(struct avr_irq_t *irq, uint32_t value, void *param)
+{
+    BOOTTEST_t *s = (BOOTTEST_t*)param;
+    if (s->replyLen < sizeof(s->reply))
+    {
+        s->reply[s->replyLen++] = (value & 0xff);
+    }
+}
+
+//------------------------------------------------------------------------------
+static bool runFor(BOOTTEST_t *s, uint32_t ms, bool untilReply, bool untilApp)
+{
+    // returns false if the simulation stopped
+    avr_cycle_count_t end = s->avr->cycle + US_TO_CYCLES((uint64_t)ms * 1000);
+    int state = cpu_Running;
+    while (s->avr->cycle < end)
+    {
+        if ((untilReply && (s->replyLen >= s->replyWant)) || (untilApp && (s->avr->pc < BOOT_START)))
+        {
+            break;
+        }
+        state = avr_run(s->avr);
+        if ((state == cpu_Done) || (state == cpu_Crashed))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+//------------------------------------------------------------------------------
+static int command(BOOTTEST_t *s, const uint8_t *cmd, uint32_t len, uint32_t timeoutMs)
+{
+    // Returns the first reply byte, -1 if none. A data block is acknowledged
+    // with its index, which has to match.
+    s->cmd = cmd;
+    s->len = len;
+    s->pos = 0;
+    s->replyLen = 0;
+    s->replyWant = 1;
+    avr_cycle_timer_register(s->avr, US_TO_CYCLES(BYTE_US), sendByte, s);
+    runFor(s, timeoutMs, true, false);
+    if ((cmd[0] == 'D') && s->replyLen && (s->reply[0] == 'K'))
+    {
+        s->replyWant = 2;
+        runFor(s, timeoutMs, true, false);
+        if ((s->replyLen < 2) || (s->reply[1] != cmd[1]))
+        {
+            printf("  block %u acknowledged as %d\n", cmd[1], (s->replyLen < 2) ? -1 : s->reply[1]);
+            avr_cycle_timer_cancel(s->avr, sendByte, s);
+            return -1;
+        }
+    }
+    avr_cycle_timer_cancel(s->avr, sendByte, s);
+    return s->replyLen ? s->reply[0] : -1;
+}
+
+//------------------------------------------------------------------------------
+static bool sync(BOOTTEST_t *s)
+{
+    static const uint8_t skSync[] = { 'U' };
+    for (uint32_t t=0; t<SYNC_TIMEOUT_MS; t+=SYNC_INTERVAL_MS)
+    {
+        if (command(s, skSync, 1, SYNC_INTERVAL_MS) == 'B')
+        {
+            // drop the answers to requests still in flight
+            runFor(s, SYNC_INTERVAL_MS, false, false);
+            return true;
+        }
+    }
+    return false;
+}
+
+//------------------------------------------------------------------------------
+static bool upload(BOOTTEST_t *s, uint16_t crc, int expected, bool corrupt)
+{
+    if (!sync(s))
+    {
+        printf("  no answer to the upload request\n");
+        return false;
+    }
+    avr_cycle_count_t start = s->avr->cycle;
+    for (uint32_t i=0; i<s->numCmds; i++)
+    {
+        uint8_t buf[260];
+        memcpy(buf, s->cmds[i].data, s->cmds[i].len);
+        bool last = (i == (s->numCmds - 1));
+        if (i == 0)
+        {
+            buf[3] = (crc & 0xff);
+            buf[4] = (crc >> 8);
+        }
+        else if (corrupt && (i == 1))
+        {
+            // a flipped bit in the first block must be rejected
+            buf[3] ^= 0x10;
+            int r = command(s, buf, s->cmds[i].len, REPLY_TIMEOUT_MS);
+            if (r != 'E')
+            {
+                printf("  corrupted block answered with %d\n", r);
+                return false;
+            }
+            buf[3] ^= 0x10;
+        }
+        else if (corrupt && (i == 2) && (buf[0] == 'D'))
+        {
+            // the acknowledge of the second block gets lost on the way to the
+            // host, which sends the block again
+            int r = command(s, buf, s->cmds[i].len, REPLY_TIMEOUT_MS);
+            if (r != 'K')
+            {
+                printf("  second block answered with %d\n", r);
+                return false;
+            }
+        }
+        int r = command(s, buf, s->cmds[i].len, REPLY_TIMEOUT_MS);
+        int want = last ? expected : 'K';
+        if (r != want)
+        {
+            printf("  command %u/%u ('%c') answered with %d, expected '%c'\n",
+                   i + 1, s->numCmds, buf[0], r, want);
+            return false;
+        }
+    }
+    printf("  %u bytes uploaded in %.0fms simulated\n", s->length,
+           (double)(s->avr->cycle - start) * 1000.0 / MCU_FREQ);
+    return true;
+}
+
+//------------------------------------------------------------------------------
+static bool started(BOOTTEST_t *s, bool expected)
+{
+    runFor(s, START_TIMEOUT_MS, false, true);
+    bool app = (s->avr->pc < BOOT_START);
+    if (app != expected)
+    {
+        printf("  application %s\n", app ? "started" : "not started");
+        return false;
+    }
+    return true;
+}
+
+//------------------------------------------------------------------------------
+static bool flashValid(BOOTTEST_t *s)
+{
+    uint16_t crc = crcXmodem(s->avr->flash, s->length);
+    if (crc != s->crc)
+    {
+        printf("  flash CRC %04x, expected %04x\n", crc, s->crc);
+        return false;
+    }
+    return true;
+}
+
+//------------------------------------------------------------------------------
+static void reset(BOOTTEST_t *s)
+{
+    // external reset, the flash is kept
+    avr_reset(s->avr);
+    s->avr->pc = BOOT_START;
+}
+
+//------------------------------------------------------------------------------
+static bool refused(BOOTTEST_t *s)
+{
+    if (!upload(s, s->crc ^ 0x0001, 'C', false) || !started(s, false))
+    {
+        return false;
+    }
+    reset(s);
+    return (started(s, false) && sync(s));
+}
+
+//------------------------------------------------------------------------------
+static bool result(const char *name, bool ok)
+{
+    printf("%-8s %s\n", name, ok ? "ok" : "FAILED");
+    return ok;
+}
+
+//------------------------------------------------------------------------------
+int main(int argc, char *argv[])
+{
+    if (argc != 3)
+    {
+        fprintf(stderr, "usage: %s <bootloader.elf> <stream.bin>\n", argv[0]);
+        return 1;
+    }
+
+    static uint8_t stream[64 * 1024];
+    FILE *f = fopen(argv[2], "rb");
+    if (!f)
+    {
+        fprintf(stderr, "%s: cannot open the stream\n", argv[2]);
+        return 1;
+    }
+    uint32_t size = fread(stream, 1, sizeof(stream), f);
+    fclose(f);
+    static BOOTTEST_t s;
+    if (!parse(&s, stream, size))
+    {
+        fprintf(stderr, "%s: not an upload stream\n", argv[2]);
+        return 1;
+    }
+
+    elf_firmware_t fw;
+    memset(&fw, 0, sizeof(fw));
+    if (elf_read_firmware(argv[1], &fw))
+    {
+        fprintf(stderr, "%s: cannot read the bootloader\n", argv[1]);
+        return 1;
+    }
+    fw.frequency = MCU_FREQ;
+    fw.tracecount = 0;
+
+    // BOOTRST is programmed, resets start the bootloader
+    s.avr = avr_make_mcu_by_name(MCU_NAME);
+    avr_init(s.avr);
+    avr_load_firmware(s.avr, &fw);
+    s.avr->log = LOG_ERROR;
+    s.avr->reset_pc = BOOT_START;
+    s.avr->pc = BOOT_START;
+
+    uint32_t flags = 0;
+    avr_ioctl(s.avr, AVR_IOCTL_UART_GET_FLAGS('0'), &flags);
+    flags &= ~AVR_UART_FLAG_STDIO;
+    avr_ioctl(s.avr, AVR_IOCTL_UART_SET_FLAGS('0'), &flags);
+    s.rx = avr_io_getirq(s.avr, AVR_IOCTL_UART_GETIRQ('0'), UART_IRQ_INPUT);
+    avr_irq_register_notify(avr_io_getirq(s.avr, AVR_IOCTL_UART_GETIRQ('0'), UART_IRQ_OUTPUT),
+                            replyByte, &s);
+
+    bool ok = true;
+    printf("image %u bytes in %u commands\n", s.length, s.numCmds);
+    ok &= result("upload", upload(&s, s.crc, 'K', true) && started(&s, true) && flashValid(&s));
+    reset(&s);
+    ok &= result("restart", started(&s, true));
+    reset(&s);
+    ok &= result("badcrc", refused(&s));
+
+    avr_terminate(s.avr);
+    return ok ? 0 : 1;
+}
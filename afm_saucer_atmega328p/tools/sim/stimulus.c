@@ -0,0 +1,398 @@
+/***********************************************************************
+ *    _   _   _             _     __                                           
+ *   /_\ | |_| |_ __ _  ___| | __/ _|_ __ ___  _ __ ___   /\/\   __ _ _ __ ___ 
+ *  //_\\| __| __/ _` |/ __| |/ / |_| '__/ _ \| '_ ` _ \ /    \ / _` | '__/ __|
+ * /  _  \ |_| || (_| | (__|   <|  _| | | (_) | | | | | / /\/\ \ (_| | |  \__ \
+ * \_/ \_/\__|\__\__,_|\___|_|\_\_| |_|  \___/|_| |_| |_\/    \/\__,_|_|  |___/
+ *
+ *                              ____ ____ ___ 
+ *                              |--< |__, |==]
+ *
+ *                      ____ ____ _  _ ____ ____ ____
+ *                      ==== |--| |__| |___ |=== |--<
+ *
+ *  Copyright (c) 2022 bitfield labs
+ * 
+ ***********************************************************************
+ *  This file is part of the Attack from Mars! RGB saucer project:
+ *  https://github.com/bitfieldlabs/afm_saucer
+ *
+ *  The AfM RGB saucer is free software: you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public License as
+ *  published by the Free Software Foundation, either version 3 of the
+ *  License, or (at your option) any later version.
+ *
+ *  AfM RGB saucer is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with afterglow.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ ***********************************************************************/
+
+// WPC lamp driver stimulus for simavr
+//
+// Runs a *_sim firmware in simavr and drives its inputs like the
+// pinball's lamp driver does: 16 bit lamp frames shifted in on the clock
+// (PD2) and data (PD4) lines, with flasher (PD3) and shaker (PD7) pulses in
+// between. The firmware reports every lamp frame it hands to the modes on
+// GPIOR1/GPIOR2, which is compared with the frames sent. Without options the
+// lamp clock is raised until frames get lost or corrupted. The simulated part
+// is the one the firmware names in its simavr section (src/sim.c).
+//
+//   stimulus [-c <kHz>] [-j <ns>] [-s <scenario>] [-t <ms>] <firmware.elf>
+//
+//   -c     lamp clock, runs this rate only instead of the sweep
+//   -j     random jitter of every clock edge
+//   -s     scenario: boot, attract, gameidle, attack, test or random (all by default)
+//   -t     simulated time per run
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include "sim_avr.h"
+#include "sim_elf.h"
+#include "sim_irq.h"
+#include "sim_cycle_timers.h"
+#include "avr_ioport.h"
+
+
+//------------------------------------------------------------------------------
+// definitions
+
+#define MCU_NAME "atmega328p"             // part simulated if the firmware names none
+#define MCU_FREQ 16000000UL
+
+#define GPIOR1_ADDR 0x4a                // SIM_LAMPS_LO data address
+#define GPIOR2_ADDR 0x4b                // SIM_LAMPS_HI data address
+
+#define LAMP_REFRESH_US 2000            // lamp frame interval of the driver [us]
+#define LAMP_GAP_US 1200                // minimum pause between lamp frames, the firmware needs 1ms [us]
+#define FLASH_INTERVAL_US 310000        // flasher pulse interval [us]
+#define FLASH_PULSE_US 3000             // flasher pulse length [us]
+#define SHAKER_INTERVAL_US 470000       // shaker line toggle interval [us]
+#define RUN_MS_DEFAULT 2000             // simulated time per run [ms]
+#define MAX_FRAMES 8192                 // lamp frames recorded per run
+#define IN_FLIGHT 2                     // sent frames the firmware may not have reported yet at the end
+#define RESYNC_WINDOW 4                 // sent frames searched for a received one
+
+#define US_TO_CYCLES(us) ((avr_cycle_count_t)(us) * (MCU_FREQ / 1000000UL))
+
+typedef uint16_t (*SCENARIO_f)(uint32_t n);
+
+typedef struct SCENARIO_s
+{
+    const char *name;
+    SCENARIO_f frame;       // lamp frame (active low) of refresh n
+} SCENARIO_t;
+
+typedef struct STIMULUS_s
+{
+    avr_t *avr;
+    avr_irq_t *clock;       // PD2
+    avr_irq_t *data;        // PD4
+    avr_irq_t *flash;       // PD3
+    avr_irq_t *shaker;      // PD7
+    const SCENARIO_t *scenario;
+    avr_cycle_count_t half;         // half lamp clock period [cycles]
+    avr_cycle_count_t jitter;       // maximum clock edge jitter [cycles]
+    avr_cycle_count_t frameStart;   // start of the current lamp frame
+    uint32_t refresh;       // lamp frames shifted so far
+    uint16_t frame;         // lamp frame being shifted
+    uint8_t edge;           // next clock edge of the frame, 0 starts a frame
+    bool shakerLevel;
+    uint16_t sent[MAX_FRAMES];      // lamp frame changes sent
+    uint32_t numSent;
+    uint16_t received[MAX_FRAMES];  // lamp frames reported by the firmware
+    uint32_t numReceived;
+} STIMULUS_t;
+
+
+//------------------------------------------------------------------------------
+// scenarios, one lamp frame per refresh
+
+static uint16_t boot(uint32_t n) { return 0x0000; }
+static uint16_t attract(uint32_t n) { return ((n / 125) & 0x01) ? 0x3333 : 0xcccc; }
+static uint16_t gameidle(uint32_t n) { return 0xffff; }
+static uint16_t attack(uint32_t n)
+{
+    // two opposite lamps chasing around, one step every 40ms
+    uint8_t s = ((n / 20) & 0x07);
+    return (uint16_t)~(0x0101 << s);
+}
+static uint16_t test(uint32_t n) { return (uint16_t)~(1 << ((n / 250) & 0x0f)); }
+static uint16_t random16(uint32_t n) { return (uint16_t)rand(); }
+
+static const SCENARIO_t skScenarios[] =
+{
+    { "boot", boot },
+    { "attract", attract },
+    { "gameidle", gameidle },
+    { "attack", attack },
+    { "test", test },
+    { "random", random16 },
+};
+#define NUM_SCENARIOS (sizeof(skScenarios) / sizeof(skScenarios[0]))
+
+static const uint32_t skSweepKHz[] = { 10, 20, 50, 75, 100, 125, 150, 200, 250, 300, 400, 500, 750, 1000 };
+#define NUM_SWEEP (sizeof(skSweepKHz) / sizeof(skSweepKHz[0]))
+
+
+//------------------------------------------------------------------------------
+static avr_cycle_count_t jitter(const STIMULUS_t *s)
+{
+    if (!s->jitter)
+    {
+        return s->half;
+    }
+    long j = (rand() % (2 * (long)s->jitter + 1)) - (long)s->jitter;
+    long h = (long)s->half + j;
+    return (h > 1) ? (avr_cycle_count_t)h : 1;
+}
+
+//------------------------------------------------------------------------------
+static avr_cycle_count_t lampClock(avr_t *avr, avr_cycle_count_t when, void *param)
+{
+    // One call per clock edge. The data line changes with the falling edge
+    // and is sampled by the firmware on the rising one.
+    STIMULUS_t *s = param;
+    if (s->edge == 0)
+    {
+        // next frame, only changes are reported by the firmware
+        s->frameStart = when;
+        s->frame = s->scenario->frame(s->refresh++);
+        uint16_t last = s->numSent ? s->sent[s->numSent - 1] : 0xffff;
+        if ((s->frame != last) && (s->numSent < MAX_FRAMES))
+        {
+            s->sent[s->numSent++] = s->frame;
+        }
+    }
+    else if (s->edge & 0x01)
+    {
+        // rising edge
+        avr_raise_irq(s->clock, 1);
+        s->edge++;
+        return when + jitter(s);
+    }
+    else
+    {
+        avr_raise_irq(s->clock, 0);
+    }
+
+    if (s->edge < 32)
+    {
+        // data for the next bit, most significant first
+        avr_raise_irq(s->data, (s->frame >> (15 - (s->edge >> 1))) & 0x01);
+        s->edge++;
+        return when + jitter(s);
+    }
+
+    // frame done, wait for the next refresh but at least for the frame gap
+    s->edge = 0;
+    avr_cycle_count_t next = s->frameStart + US_TO_CYCLES(LAMP_REFRESH_US);
+    avr_cycle_count_t minNext = when + US_TO_CYCLES(LAMP_GAP_US);
+    return (next > minNext) ? next : minNext;
+}
+
+//------------------------------------------------------------------------------
+static avr_cycle_count_t flashPulse(avr_t *avr, avr_cycle_count_t when, void *param)
+{
+    STIMULUS_t *s = param;
+    if (s->flash->value)
+    {
+        // active low pulse
+        avr_raise_irq(s->flash, 0);
+        return when + US_TO_CYCLES(FLASH_PULSE_US);
+    }
+    avr_raise_irq(s->flash, 1);
+    return when + US_TO_CYCLES(FLASH_INTERVAL_US - FLASH_PULSE_US);
+}
+
+//------------------------------------------------------------------------------
+static avr_cycle_count_t shakerToggle(avr_t *avr, avr_cycle_count_t when, void *param)
+{
+    STIMULUS_t *s = param;
+    s->shakerLevel = !s->shakerLevel;
+    avr_raise_irq(s->shaker, s->shakerLevel);
+    return when + US_TO_CYCLES(SHAKER_INTERVAL_US);
+}
+
+//------------------------------------------------------------------------------
+static void lampsReported(avr_t *avr, avr_io_addr_t addr, uint8_t v, void *param)
+{
+    // the high byte is written last, the low byte is already in place
+    STIMULUS_t *s = param;
+    avr->data[addr] = v;
+    if (s->numReceived < MAX_FRAMES)
+    {
+        s->received[s->numReceived++] = (uint16_t)((v << 8) | avr->data[GPIOR1_ADDR]);
+    }
+}
+
+//------------------------------------------------------------------------------
+static bool run(const char *elf, const SCENARIO_t *scenario, uint32_t kHz, uint32_t jitterNs,
+                uint32_t ms, bool verbose)
+{
+    static STIMULUS_t s;
+    memset(&s, 0, sizeof(s));
+
+    elf_firmware_t fw;
+    memset(&fw, 0, sizeof(fw));
+    if (elf_read_firmware(elf, &fw))
+    {
+        fprintf(stderr, "%s: cannot read the firmware\n", elf);
+        exit(1);
+    }
+    fw.frequency = MCU_FREQ;
+    fw.tracecount = 0;      // no VCD needed here
+
+    s.avr = avr_make_mcu_by_name(fw.mmcu[0] ? fw.mmcu : MCU_NAME);
+    if (!s.avr)
+    {
+        fprintf(stderr, "%s: simavr does not know the part %s\n", elf, fw.mmcu);
+        exit(1);
+    }
+    avr_init(s.avr);
+    avr_load_firmware(s.avr, &fw);
+    s.avr->log = LOG_ERROR;
+
+    s.clock = avr_io_getirq(s.avr, AVR_IOCTL_IOPORT_GETIRQ('D'), 2);
+    s.flash = avr_io_getirq(s.avr, AVR_IOCTL_IOPORT_GETIRQ('D'), 3);
+    s.data = avr_io_getirq(s.avr, AVR_IOCTL_IOPORT_GETIRQ('D'), 4);
+    s.shaker = avr_io_getirq(s.avr, AVR_IOCTL_IOPORT_GETIRQ('D'), 7);
+    avr_raise_irq(s.clock, 0);
+    avr_raise_irq(s.flash, 1);
+    avr_raise_irq(s.shaker, 0);
+    avr_register_io_write(s.avr, GPIOR2_ADDR, lampsReported, &s);
+
+    s.scenario = scenario;
+    s.half = (MCU_FREQ / 2000UL) / kHz;
+    s.jitter = ((avr_cycle_count_t)jitterNs * (MCU_FREQ / 1000000UL)) / 1000;
+    avr_cycle_timer_register(s.avr, US_TO_CYCLES(100000), lampClock, &s);
+    avr_cycle_timer_register(s.avr, US_TO_CYCLES(150000), flashPulse, &s);
+    avr_cycle_timer_register(s.avr, US_TO_CYCLES(170000), shakerToggle, &s);
+
+    avr_cycle_count_t end = US_TO_CYCLES((uint64_t)ms * 1000);
+    int state = cpu_Running;
+    while ((s.avr->cycle < end) && (state != cpu_Done) && (state != cpu_Crashed))
+    {
+        state = avr_run(s.avr);
+    }
+
+    // every received frame must be the next change sent, lost ones are
+    // skipped over, anything else is corrupted
+    uint32_t i = 0;
+    uint32_t corrupted = 0;
+    uint32_t missed = 0;
+    for (uint32_t r=0; r<s.numReceived; r++)
+    {
+        uint32_t j = i;
+        while ((j < s.numSent) && (j < (i + RESYNC_WINDOW)) && (s.sent[j] != s.received[r]))
+        {
+            j++;
+        }
+        if ((j < s.numSent) && (s.sent[j] == s.received[r]))
+        {
+            missed += (j - i);
+            i = j + 1;
+        }
+        else
+        {
+            corrupted++;
+        }
+    }
+    uint32_t pending = (s.numSent - i);
+    if (pending > IN_FLIGHT)
+    {
+        missed += (pending - IN_FLIGHT);
+    }
+    bool ok = ((state != cpu_Crashed) && !corrupted && !missed);
+    if (verbose || !ok)
+    {
+        printf("%-9s %5ukHz jitter %4uns: %5u sent, %5u received, %3u corrupted, %3u missed%s  %s\n",
+               scenario->name, kHz, jitterNs, s.numSent, s.numReceived, corrupted, missed,
+               (state == cpu_Crashed) ? ", crashed" : "", ok ? "ok" : "FAILED");
+    }
+    avr_terminate(s.avr);
+    return ok;
+}
+
+//------------------------------------------------------------------------------
+int main(int argc, char *argv[])
+{
+    uint32_t kHz = 0;
+    uint32_t jitterNs = 0;
+    uint32_t ms = RUN_MS_DEFAULT;
+    const char *scenarioName = NULL;
+    int opt;
+    while ((opt = getopt(argc, argv, "c:j:s:t:")) != -1)
+    {
+        switch (opt)
+        {
+            case 'c': kHz = strtoul(optarg, NULL, 0); break;
+            case 'j': jitterNs = strtoul(optarg, NULL, 0); break;
+            case 's': scenarioName = optarg; break;
+            case 't': ms = strtoul(optarg, NULL, 0); break;
+            default:
+                fprintf(stderr, "usage: %s [-c kHz] [-j ns] [-s scenario] [-t ms] <firmware.elf>\n", argv[0]);
+                return 1;
+        }
+    }
+    if (optind >= argc)
+    {
+        fprintf(stderr, "usage: %s [-c kHz] [-j ns] [-s scenario] [-t ms] <firmware.elf>\n", argv[0]);
+        return 1;
+    }
+    const char *elf = argv[optind];
+    srand(1);
+
+    // the scenarios to run
+    const SCENARIO_t *scenarios[NUM_SCENARIOS];
+    uint8_t num = 0;
+    for (uint8_t i=0; i<NUM_SCENARIOS; i++)
+    {
+        if (!scenarioName || (strcmp(scenarioName, skScenarios[i].name) == 0))
+        {
+            scenarios[num++] = &skScenarios[i];
+        }
+    }
+    if (!num)
+    {
+        fprintf(stderr, "unknown scenario %s\n", scenarioName);
+        return 1;
+    }
+
+    // a single clock rate
+    if (kHz)
+    {
+        bool ok = true;
+        for (uint8_t i=0; i<num; i++)
+        {
+            ok &= run(elf, scenarios[i], kHz, jitterNs, ms, true);
+        }
+        return ok ? 0 : 1;
+    }
+
+    // raise the clock until frames get lost
+    uint32_t maxKHz = 0;
+    for (uint8_t k=0; k<NUM_SWEEP; k++)
+    {
+        bool ok = true;
+        for (uint8_t i=0; (i<num) && ok; i++)
+        {
+            ok = run(elf, scenarios[i], skSweepKHz[k], jitterNs, ms, false);
+        }
+        if (!ok)
+        {
+            break;
+        }
+        printf("%5ukHz ok\n", skSweepKHz[k]);
+        maxKHz = skSweepKHz[k];
+    }
+    printf("maximum lamp clock without bit loss: %ukHz\n", maxKHz);
+    return maxKHz ? 0 : 1;
+}
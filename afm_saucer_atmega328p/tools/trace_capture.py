@@ -0,0 +1,45 @@
+#!/usr/bin/env python3
+#
+# Attack from Mars! RGB saucer - trace capture
+#
+# Polls the trace ring buffer of a TRACE_RECORDER firmware build over the
+# serial port and appends all dumps to a trace file, which can be replayed
+# with native/replay.
+#
+#   trace_capture.py [-p /dev/ttyUSB0] [-i 0.5] game.trc
+#
+# Requires pyserial.
+
+import argparse
+import sys
+import time
+
+import serial
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Capture saucer input traces')
+    parser.add_argument('-p', '--port', default='/dev/ttyUSB0', help='serial port')
+    parser.add_argument('-b', '--baud', type=int, default=115200, help='baud rate')
+    parser.add_argument('-i', '--interval', type=float, default=0.5,
+                        help='dump interval [s], must stay well below 1s')
+    parser.add_argument('file', help='output trace file')
+    args = parser.parse_args()
+
+    with serial.Serial(args.port, args.baud, timeout=0.1) as port, open(args.file, 'w') as out:
+        print('capturing, press Ctrl-C to stop', file=sys.stderr)
+        try:
+            while True:
+                port.write(b'd')
+                deadline = time.monotonic() + args.interval
+                while time.monotonic() < deadline:
+                    line = port.readline().decode('ascii', 'replace')
+                    if line:
+                        out.write(line)
+                out.flush()
+        except KeyboardInterrupt:
+            pass
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,539 @@
+#!/usr/bin/env python3
+#
+# Attack from Mars! RGB saucer - worst case execution time analysis
+#
+# Static analysis of the linked firmware: disassembles the ELF, builds the
+# control flow graph of every reachable function, bounds its loops with the
+# LOOP_BOUNDS table and sums the AVR instruction cycles along the longest
+# path, with the callees' worst cases at every call. It reports
+#
+#   - one iteration of the main loop, the work of a full frame, plus the
+#     interrupts which can hit during a frame
+#   - every interrupt service routine
+#   - every section running with the interrupts disabled
+#
+# and fails if the frame or the lamp clock interrupt latency exceed their
+# budgets. As PlatformIO extra script it adds the `wcet` target:
+#
+#   pio run -e ATmega328P -t wcet
+#   tools/wcet.py .pio/build/ATmega328P/firmware.elf     (standalone)
+#
+# Jump tables can't be followed statically, the script turns them off for all
+# builds so the analysed firmware is the one which ships. It also adds debug
+# info, which tells the loops inlined from other functions apart.
+
+import argparse
+import re
+import subprocess
+import sys
+
+F_CPU = 16000000                # CPU clock [Hz]
+FRAME_BUDGET_US = 20000         # base frame, LED_UPDATE_INT in src/main.c [us]
+LAMP_CLOCK_KHZ = 100            # fastest lamp clock the interrupt latency has to keep up with [kHz]
+ISR_OVERHEAD = 4 + 3            # interrupt response and vector table jump [cycles]
+
+# Interrupts per frame at their fastest: 16 lamp clocks per lamp frame every
+# 2ms, single flasher, shaker and DIP edges, one EEPROM byte per 3.3ms and
+# one byte per serial character at 115200 baud.
+ISR_PER_FRAME = {
+    'INT0_vect': 160,
+    'INT1_vect': 1,
+    'PCINT1_vect': 1,
+    'PCINT2_vect': 2,
+    'EE_READY_vect': 7,
+    'USART_UDRE_vect': 231,
+}
+
+# ATmega328P vector numbers of __vector_<n>, the same on the ATmega88PA and ATmega168PA
+VECTOR_NAMES = {
+    1: 'INT0_vect', 2: 'INT1_vect', 3: 'PCINT0_vect', 4: 'PCINT1_vect',
+    5: 'PCINT2_vect', 6: 'WDT_vect', 7: 'TIMER2_COMPA_vect', 8: 'TIMER2_COMPB_vect',
+    9: 'TIMER2_OVF_vect', 10: 'TIMER1_CAPT_vect', 11: 'TIMER1_COMPA_vect',
+    12: 'TIMER1_COMPB_vect', 13: 'TIMER1_OVF_vect', 14: 'TIMER0_COMPA_vect',
+    15: 'TIMER0_COMPB_vect', 16: 'TIMER0_OVF_vect', 17: 'SPI_STC_vect',
+    18: 'USART_RX_vect', 19: 'USART_UDRE_vect', 20: 'USART_TX_vect',
+    21: 'ADC_vect', 22: 'EE_READY_vect', 23: 'ANALOG_COMP_vect', 24: 'TWI_vect',
+    25: 'SPM_READY_vect',
+}
+
+# Maximum iterations of every loop in a function, a list gives them by
+# nesting depth. A loop inlined into a caller keeps the bound of the function
+# it was written in, found from the debug info, and never takes the caller's.
+# The outermost loop of main is the frame loop and is analysed for one
+# iteration.
+LOOP_BOUNDS = {
+    'main': [1, 20, 20],
+    'chaseUpdate': 2,               # CHASE_MAX_STEP
+    'decodeFrame': 16,              # ops and runs within NUM_LEDS
+    'fxAdvance': 16,
+    'fxRender': 16,
+    'fxShockwave': 16,              # innermost LED radius
+    'sendByte': 8,
+    'updateLEDState': 5,            # SM_NUM
+    'renderBackground': 20,
+    'renderForeground': 16,
+    'renderFlasher': 4,
+    'advanceFrame': 16,
+    'updateLEDs': 20,               # pixels, base frame steps
+    'updateLEDActive': 16,
+    'crossfade': 16,
+    'crossfadeShown': 16,
+    'renderLEDs': 20,
+    'refreshLEDs': 20,
+    'warmStateChecksum': 16,        # sizeof(WARM_STATE_t)
+    'saveWarmState': 16,
+    'allocParticle': 8,             # PARTICLE_POOL_SIZE
+    'particlesBurst': 4,
+    'particlesAdvance': 8,
+    'particlesActive': 8,
+    'particlesRender': 8,
+    'usageChecksum': 35,            # sizeof(USAGE_t)
+    'usageTime': 35,
+    'memcpy': 128,
+    'memset': 128,
+    '__udivmodqi4': 9,
+    '__udivmodhi4': 17,
+    '__udivmodsi4': 33,
+}
+
+IDLE = {'timerWaitUntil', 'passthrough'}                            # waiting for the frame time, or renders filling it
+EXCLUDED = {'usageDump', 'debugStats', 'traceDump', 'mirrorStats'}    # serial dumps on request
+
+SREG = 0x3f
+
+CYCLES = {
+    'adiw': 2, 'sbiw': 2, 'mul': 2, 'muls': 2, 'mulsu': 2, 'fmul': 2,
+    'fmuls': 2, 'fmulsu': 2, 'ld': 2, 'ldd': 2, 'st': 2, 'std': 2, 'lds': 2,
+    'sts': 2, 'push': 2, 'pop': 2, 'sbi': 2, 'cbi': 2, 'rjmp': 2, 'ijmp': 2,
+    'lpm': 3, 'jmp': 3, 'rcall': 3, 'icall': 3, 'call': 4, 'ret': 4, 'reti': 4,
+}
+SKIPS = {'cpse', 'sbrc', 'sbrs', 'sbic', 'sbis'}
+RETURNS = {'ret', 'reti'}
+
+
+class AnalysisError(Exception):
+    pass
+
+
+class Insn:
+    def __init__(self, addr, size, op, args, target):
+        self.addr = addr
+        self.size = size
+        self.op = op
+        self.args = args
+        self.target = target
+
+
+def parse_symbols(text):
+    # objdump -t: address, flags, section, size, name
+    funcs = {}
+    for line in text.splitlines():
+        m = re.match(r'^([0-9a-f]{8})\s(.{7})\s(\S+)\s+([0-9a-f]+)\s+(\S+)$', line)
+        if m and ('F' in m.group(2)) and (m.group(3) == '.text'):
+            funcs[int(m.group(1), 16)] = m.group(5)
+    return funcs
+
+
+def parse_code(text):
+    # objdump -d, every instruction with its length and branch target
+    code = {}
+    for line in text.splitlines():
+        m = re.match(r'^\s*([0-9a-f]+):\t((?:[0-9a-f]{2} )+)\s*\t(\S+)\s*([^;]*)(?:;\s*(0x[0-9a-f]+))?', line)
+        if not m:
+            continue
+        addr = int(m.group(1), 16)
+        size = len(m.group(2).split())
+        op = m.group(3)
+        args = m.group(4).strip()
+        target = None
+        if m.group(5):
+            target = int(m.group(5), 16)
+        elif op in ('call', 'jmp'):
+            target = int(args, 16)
+        code[addr] = Insn(addr, size, op, args, target)
+    return code
+
+
+def parse_data_words(text):
+    # objdump -s -j .data, 16 bit little endian words at every byte offset
+    data = bytearray()
+    for line in text.splitlines():
+        m = re.match(r'^ [0-9a-f]{4,8} ((?:[0-9a-f]{2,8} ?){1,4})', line)
+        if m:
+            data += bytes.fromhex(m.group(1).replace(' ', ''))
+    return {data[i] | (data[i + 1] << 8) for i in range(len(data) - 1)}
+
+
+def base_name(name):
+    # LTO and cloning suffixes like .lto_priv.0 or .constprop.0
+    return name.split('.')[0]
+
+
+def isr_name(name):
+    m = re.match(r'^__vector_(\d+)$', name)
+    if m:
+        return VECTOR_NAMES.get(int(m.group(1)), name)
+    return None
+
+
+class Analyser:
+    def __init__(self, code, funcs, pointers, origins):
+        self.code = code
+        self.funcs = funcs
+        self.origins = origins
+        self.wcet = {}
+        self.active = set()
+        self.isections = []         # (cycles, function) with interrupts disabled
+        # functions whose address is stored in data, the candidates of icall
+        self.icall_targets = [a for a in funcs if (a // 2) in pointers]
+
+    def insn(self, addr, func):
+        if addr not in self.code:
+            raise AnalysisError('%s: no instruction at 0x%x' % (func, addr))
+        return self.code[addr]
+
+    def callees(self, ins, entry):
+        # functions called by an instruction, a jump to another function is a tail call
+        if (ins.op == 'rcall') and (ins.target == ins.addr + ins.size):
+            # rcall .+0 pushes the return address to reserve stack space
+            return []
+        if ins.op in ('call', 'rcall'):
+            return [ins.target]
+        if ins.op == 'icall':
+            if not self.icall_targets:
+                raise AnalysisError('%s: indirect call without known targets' % self.funcs[entry])
+            return self.icall_targets
+        if (ins.op in ('jmp', 'rjmp')) and (ins.target in self.funcs) and (ins.target != entry):
+            return [ins.target]
+        return []
+
+    def successors(self, ins, entry):
+        name = self.funcs[entry]
+        nxt = ins.addr + ins.size
+        if ins.op in RETURNS:
+            return []
+        if ins.op == 'ijmp':
+            raise AnalysisError('%s: indirect jump at 0x%x, jump tables have to be off' % (name, ins.addr))
+        if ins.op in ('jmp', 'rjmp'):
+            if ins.target == ins.addr:
+                raise AnalysisError('%s: endless loop at 0x%x' % (name, ins.addr))
+            return [] if ((ins.target in self.funcs) and (ins.target != entry)) else [ins.target]
+        if ins.op.startswith('br'):
+            return [nxt, ins.target]
+        if ins.op in SKIPS:
+            return [nxt, nxt + self.insn(nxt, name).size]
+        return [nxt]
+
+    def cycles(self, ins, entry):
+        # worst case of the instruction itself, taken branches and skips over two words
+        if ins.op.startswith('br'):
+            c = 2
+        elif ins.op in SKIPS:
+            c = 1 + (self.insn(ins.addr + ins.size, self.funcs[entry]).size // 2)
+        else:
+            c = CYCLES.get(ins.op, 1)
+        return c + max([self.function(t) for t in self.callees(ins, entry)] or [0])
+
+    def graph(self, entry):
+        # instructions reachable from the entry without calls
+        name = self.funcs[entry]
+        succ = {}
+        todo = [entry]
+        while todo:
+            a = todo.pop()
+            if a in succ:
+                continue
+            succ[a] = self.successors(self.insn(a, name), entry)
+            todo += succ[a]
+        return succ
+
+    def loops(self, entry, succ):
+        # natural loops from the dominator tree, as (header, body) pairs
+        order = []
+        seen = set()
+        stack = [(entry, iter(succ[entry]))]
+        seen.add(entry)
+        while stack:
+            node, it = stack[-1]
+            nxt = next(it, None)
+            if nxt is None:
+                order.append(node)
+                stack.pop()
+            elif nxt not in seen:
+                seen.add(nxt)
+                stack.append((nxt, iter(succ[nxt])))
+        order.reverse()
+        index = {a: i for i, a in enumerate(order)}
+        preds = {a: [] for a in order}
+        for a in order:
+            for s in succ[a]:
+                preds[s].append(a)
+        idom = {entry: entry}
+        changed = True
+        while changed:
+            changed = False
+            for a in order[1:]:
+                new = None
+                for p in preds[a]:
+                    if p not in idom:
+                        continue
+                    if new is None:
+                        new = p
+                        continue
+                    x, y = p, new
+                    while x != y:
+                        while index[x] > index[y]:
+                            x = idom[x]
+                        while index[y] > index[x]:
+                            y = idom[y]
+                    new = x
+                if idom.get(a) != new:
+                    idom[a] = new
+                    changed = True
+
+        def dominates(h, a):
+            while True:
+                if a == h:
+                    return True
+                if a == entry:
+                    return False
+                a = idom[a]
+
+        bodies = {}
+        for a in order:
+            for s in succ[a]:
+                if index[s] <= index[a]:
+                    if not dominates(s, a):
+                        raise AnalysisError('%s: irreducible loop at 0x%x' % (self.funcs[entry], s))
+                    body = bodies.setdefault(s, {s})
+                    todo = [a]
+                    while todo:
+                        n = todo.pop()
+                        if n not in body:
+                            body.add(n)
+                            todo += preds[n]
+        return bodies
+
+    def origin(self, entry, addr):
+        # function a loop was written in, the innermost of an inline chain
+        name = self.origins.get(addr, '??')
+        return base_name(self.funcs[entry]) if (name == '??') else base_name(name)
+
+    def region(self, entry, succ, nodes, start, loops, chain, header=None):
+        # longest path from start through nodes, inner loops collapsed to their
+        # bounded cost, chain holds the origins of the loops around the one
+        # with the given header
+        name = self.funcs[entry]
+        inner = [h for h in loops if (h in nodes) and (h != header)]
+        outer = [h for h in inner if not any((h != o) and (h in loops[o]) for o in inner)]
+        owner = {a: a for a in nodes}
+        for h in outer:
+            for a in loops[h]:
+                owner[a] = h
+        cost = {}
+        edges = {}
+        for a in nodes:
+            o = owner[a]
+            if o not in cost:
+                if o in outer:
+                    origin = self.origin(entry, o)
+                    bound = loop_bound(name, origin, chain.count(origin))
+                    cost[o] = bound * self.region(entry, succ, loops[o], o, loops, chain + [origin], o)
+                else:
+                    cost[o] = self.cycles(self.insn(o, name), entry)
+                edges[o] = set()
+            for s in succ[a]:
+                if (s in nodes) and (s != start) and (owner[s] != o):
+                    edges[o].add(owner[s])
+        # longest path in the acyclic collapsed graph
+        order = []
+        seen = set()
+        stack = [(start, iter(edges[start]))]
+        seen.add(start)
+        while stack:
+            node, it = stack[-1]
+            nxt = next(it, None)
+            if nxt is None:
+                order.append(node)
+                stack.pop()
+            elif nxt not in seen:
+                seen.add(nxt)
+                stack.append((nxt, iter(edges[nxt])))
+        best = {}
+        for n in order:
+            best[n] = cost[n] + max([best[s] for s in edges[n]] or [0])
+        return best[start]
+
+    def function(self, entry):
+        name = self.funcs.get(entry)
+        if name is None:
+            raise AnalysisError('call to 0x%x, not a function' % entry)
+        if entry in self.wcet:
+            return self.wcet[entry]
+        if (base_name(name) in IDLE) or (base_name(name) in EXCLUDED):
+            return 0
+        if entry in self.active:
+            raise AnalysisError('%s: recursion' % name)
+        self.active.add(entry)
+        succ = self.graph(entry)
+        loops = self.loops(entry, succ)
+        self.wcet[entry] = self.region(entry, succ, set(succ), entry, loops, [])
+        self.disabled(entry, succ)
+        self.active.discard(entry)
+        return self.wcet[entry]
+
+    def frame(self, entry):
+        # one iteration of the outermost loop of main
+        succ = self.graph(entry)
+        loops = self.loops(entry, succ)
+        if not loops:
+            raise AnalysisError('main: no frame loop')
+        self.active.add(entry)
+        h = max(loops, key=lambda h: len(loops[h]))
+        cycles = self.region(entry, succ, loops[h], h, loops, [self.origin(entry, h)], h)
+        self.disabled(entry, succ)
+        self.active.discard(entry)
+        return cycles
+
+    def disabled(self, entry, succ):
+        # longest path from every cli to the sei or SREG restore ending it
+        name = self.funcs[entry]
+        for a in succ:
+            if self.code[a].op != 'cli':
+                continue
+            best = {}
+            visiting = set()
+
+            def longest(n):
+                if n in best:
+                    return best[n]
+                ins = self.code[n]
+                if (ins.op == 'sei') or ((ins.op == 'out') and ins.args.startswith('0x%x,' % SREG)):
+                    return 1
+                if ins.op in RETURNS:
+                    raise AnalysisError('%s: returns with the interrupts disabled' % name)
+                if n in visiting:
+                    raise AnalysisError('%s: loop with the interrupts disabled' % name)
+                visiting.add(n)
+                best[n] = self.cycles(ins, entry) + max([longest(s) for s in succ[n]] or [0])
+                visiting.discard(n)
+                return best[n]
+
+            self.isections.append((longest(a), name))
+
+
+def loop_bound(name, origin, depth):
+    if origin not in LOOP_BOUNDS:
+        where = '' if (origin == base_name(name)) else (' inlined from %s' % origin)
+        raise AnalysisError('%s: no loop bound for a loop%s, add %s to LOOP_BOUNDS' % (name, where, origin))
+    bound = LOOP_BOUNDS[origin]
+    if isinstance(bound, list):
+        return bound[min(depth, len(bound) - 1)]
+    return bound
+
+
+def us(cycles):
+    return cycles * 1e6 / F_CPU
+
+
+def parse_origins(text):
+    # addr2line -a -f -i, the address followed by function and line pairs
+    # from the innermost inlined function out
+    origins = {}
+    addr = None
+    lines = text.splitlines()
+    for i, line in enumerate(lines):
+        if line.startswith('0x'):
+            addr = int(line, 16)
+            if i + 1 < len(lines):
+                origins[addr] = lines[i + 1].strip()
+    return origins
+
+
+def analyse(code, funcs, pointers, origins):
+    if not any(name != '??' for name in origins.values()):
+        raise AnalysisError('no debug info, inlined loops can\'t be told from their callers')
+    an = Analyser(code, funcs, pointers, origins)
+    entries = {name: addr for addr, name in funcs.items()}
+    if 'main' not in entries:
+        raise AnalysisError('no main')
+
+    frame = an.frame(entries['main'])
+    isrs = {}
+    for addr, name in funcs.items():
+        vect = isr_name(name)
+        if vect:
+            isrs[vect] = ISR_OVERHEAD + an.function(addr)
+
+    ok = True
+    print('Worst case execution time at %dMHz:' % (F_CPU // 1000000))
+    print('  %-18s %7s %9s %6s' % ('interrupt', 'cycles', 'us', 'frame'))
+    load = 0
+    for vect in sorted(isrs):
+        n = ISR_PER_FRAME.get(vect, 1)
+        load += n * isrs[vect]
+        print('  %-18s %7d %9.1f %5dx' % (vect, isrs[vect], us(isrs[vect]), n))
+
+    total = frame + load
+    budget = FRAME_BUDGET_US * F_CPU // 1000000
+    print('  %-18s %7d %9.1f' % ('frame loop', frame, us(frame)))
+    print('  %-18s %7d %9.1f' % ('interrupts/frame', load, us(load)))
+    print('  %-18s %7d %9.1f  of %d (%d%%)' % ('frame total', total, us(total), budget, total * 100 // budget))
+    if total > budget:
+        print('Error: a frame can take %.1fms, more than the %.1fms frame' % (us(total) / 1000, FRAME_BUDGET_US / 1000))
+        ok = False
+
+    # the lamp clock interrupt comes first once the longest blocking section ends
+    blocked = max(an.isections + [(c, v) for v, c in isrs.items() if v != 'INT0_vect'] + [(0, '-')])
+    print('  %-18s %7d %9.1f  (%s)' % ('interrupts off', blocked[0], us(blocked[0]), blocked[1]))
+    if 'INT0_vect' in isrs:
+        latency = blocked[0] + isrs['INT0_vect']
+        period = F_CPU // (LAMP_CLOCK_KHZ * 1000)
+        print('  %-18s %7d %9.1f  of %d at %dkHz' % ('lamp clock', latency, us(latency), period, LAMP_CLOCK_KHZ))
+        if latency > period:
+            print('Error: the lamp clock interrupt can take %.1fus, longer than a %dkHz clock period' % (us(latency), LAMP_CLOCK_KHZ))
+            ok = False
+
+    print('Largest functions:')
+    for addr in sorted(an.wcet, key=lambda a: -an.wcet[a])[:8]:
+        print('  %7d %9.1f  %s' % (an.wcet[addr], us(an.wcet[addr]), funcs[addr]))
+    return ok
+
+
+def run(objdump, elf):
+    try:
+        symbols = subprocess.check_output([objdump, '-t', elf], universal_newlines=True)
+        disasm = subprocess.check_output([objdump, '-d', elf], universal_newlines=True)
+        data = subprocess.check_output([objdump, '-s', '-j', '.data', elf], universal_newlines=True)
+        code = parse_code(disasm)
+        addrs = ''.join('%x\n' % a for a in sorted(code))
+        lines = subprocess.check_output([objdump.replace('objdump', 'addr2line'), '-a', '-f', '-i', '-e', elf],
+                                        input=addrs, universal_newlines=True)
+        return analyse(code, parse_symbols(symbols), parse_data_words(data), parse_origins(lines))
+    except AnalysisError as e:
+        print('Error: WCET analysis failed, %s' % e)
+        return False
+
+
+try:
+    Import('env')
+except NameError:
+    env = None
+
+if env is not None:
+    def wcet_target(source, target, env):
+        global F_CPU
+        F_CPU = int(env.BoardConfig().get('build.f_cpu', '16000000L').rstrip('UL'))
+        objdump = env.subst('$SIZETOOL').replace('size', 'objdump')
+        if not run(objdump, env.subst('$BUILD_DIR/${PROGNAME}.elf')):
+            env.Exit(1)
+
+    env.Append(CCFLAGS=['-fno-jump-tables', '-g'], LINKFLAGS=['-fno-jump-tables', '-g'])
+    env.AddCustomTarget('wcet', '$BUILD_DIR/${PROGNAME}.elf', wcet_target,
+                        title='WCET', description='Worst case execution time analysis')
+elif __name__ == '__main__':
+    parser = argparse.ArgumentParser(description='Worst case execution time analysis of the saucer firmware')
+    parser.add_argument('elf', help='firmware ELF file')
+    parser.add_argument('--objdump', default='avr-objdump', help='objdump of the AVR toolchain')
+    args = parser.parse_args()
+    sys.exit(0 if run(args.objdump, args.elf) else 1)
@@ -0,0 +1,181 @@
+#!/usr/bin/env python3
+#
+# Attack from Mars! RGB saucer - WS2812 waveform verifier
+#
+# Decodes the LED data lines from a simavr VCD trace of the ATmega328P_sim
+# firmware back into pixel frames, checks every pulse against the WS2812
+# timing limits and compares the frames with the ones the firmware meant to
+# send (the "F ..." lines simavr prints from the console register).
+#
+#   ws2812_vcd.py saucer.vcd [sim.log]
+#
+# Exits with 1 on timing violations or frame mismatches.
+
+import re
+import sys
+
+NUM_LEDS = 16               # saucer LEDs on PD5
+NUM_FLASHER = 4             # flashers on PD6
+
+# WS2812 timing limits [ns], conservative over the common datasheet revisions
+T0H_MIN = 200
+T0H_MAX = 500
+T1H_MIN = 625
+T1H_MAX = 5000
+TL_MIN = 450                # low time between bits
+TL_MAX = 5000               # longer lows may latch older pixels
+RES_MIN = 280000            # latch gap of current pixels
+BIT_THRESHOLD = 550         # high times above are 1 bits
+
+SIGNALS = (('PD5', NUM_LEDS), ('PD6', NUM_FLASHER))
+UNITS = {'s': 1e9, 'ms': 1e6, 'us': 1e3, 'ns': 1.0, 'ps': 1e-3, 'fs': 1e-6}
+
+
+def parse_vcd(path):
+    # returns {name: [(time_ns, level), ...]}
+    ids = {}
+    changes = {}
+    scale = 1.0
+    now = 0
+    with open(path) as f:
+        text = f.read()
+    m = re.search(r'\$timescale\s+(\d+)\s*(\w+)\s+\$end', text)
+    if m:
+        scale = int(m.group(1)) * UNITS[m.group(2)]
+    for m in re.finditer(r'\$var\s+\S+\s+\d+\s+(\S+)\s+(\S+).*?\$end', text):
+        ids[m.group(1)] = m.group(2)
+        changes[m.group(2)] = []
+    body = text[text.find('$enddefinitions'):].split('\n', 1)[-1]
+    for tok in body.split('\n'):
+        tok = tok.strip()
+        if not tok or tok.startswith('$'):
+            continue
+        if tok[0] == '#':
+            now = int(tok[1:]) * scale
+        elif tok[0] in 'bB':
+            value, ident = tok[1:].split()
+            if ident in ids:
+                level = int(value.replace('x', '0').replace('z', '0'), 2) != 0
+                changes[ids[ident]].append((now, level))
+        elif tok[0] in '01xz' and tok[1:] in ids:
+            changes[ids[tok[1:]]].append((now, tok[0] == '1'))
+    return changes
+
+
+class Stats:
+    def __init__(self, name, lo, hi):
+        self.name, self.lo, self.hi = name, lo, hi
+        self.min = self.max = None
+        self.violations = 0
+
+    def add(self, v):
+        self.min = v if self.min is None else min(self.min, v)
+        self.max = v if self.max is None else max(self.max, v)
+        if (self.lo is not None and v < self.lo) or (self.hi is not None and v > self.hi):
+            self.violations += 1
+
+    def line(self):
+        if self.min is None:
+            return '  %-12s -' % self.name
+        limit = '%s..%s' % ('' if self.lo is None else int(self.lo), '' if self.hi is None else int(self.hi))
+        return '  %-12s min %8.0fns  max %8.0fns  limit %-12s %s' % (
+            self.name, self.min, self.max, limit,
+            'ok' if not self.violations else '%d VIOLATIONS' % self.violations)
+
+
+def decode(changes, num_pixels):
+    # split the pulse train at the latch gaps and decode the bits of each frame
+    t0h = Stats('0 bit high', T0H_MIN, T0H_MAX)
+    t1h = Stats('1 bit high', T1H_MIN, T1H_MAX)
+    tl = Stats('bit low', TL_MIN, TL_MAX)
+    res = Stats('latch gap', RES_MIN, None)
+    wire = Stats('wire time', None, None)
+    frames = []
+    bits = []
+    start = rise = fall = None
+    level = False
+
+    def end_frame():
+        if bits:
+            wire.add(fall - start)
+            data = [int(''.join(str(b) for b in bits[i:i + 8]), 2) for i in range(0, len(bits) - 7, 8)]
+            frames.append(([tuple(data[i:i + 3]) for i in range(0, len(data) - 2, 3)], len(bits)))
+
+    for t, l in changes:
+        if l == level:
+            continue
+        level = l
+        if l:
+            if fall is not None:
+                low = t - fall
+                if low >= RES_MIN / 4:
+                    # a gap this long ends the frame, it must reach the latch time
+                    res.add(low)
+                    end_frame()
+                    bits = []
+                    start = None
+                else:
+                    tl.add(low)
+            if start is None:
+                start = t
+            rise = t
+        elif rise is not None:
+            high = t - rise
+            bit = high > BIT_THRESHOLD
+            (t1h if bit else t0h).add(high)
+            bits.append(1 if bit else 0)
+            fall = t
+    end_frame()
+    stats = (t0h, t1h, tl, res, wire)
+    bad = [f for f in frames if f[1] != num_pixels * 24]
+    return [f[0] for f in frames], stats, len(bad)
+
+
+def parse_log(path):
+    frames = []
+    with open(path, errors='replace') as f:
+        for line in f:
+            m = re.search(r'F((?: [0-9a-f]{6})+)', line)
+            if m:
+                frames.append([tuple(bytes.fromhex(w)) for w in m.group(1).split()])
+    return frames
+
+
+def main():
+    if len(sys.argv) not in (2, 3):
+        sys.exit('usage: ws2812_vcd.py <trace.vcd> [simavr console log]')
+    changes = parse_vcd(sys.argv[1])
+    failed = False
+    decoded = {}
+    for name, num in SIGNALS:
+        if name not in changes:
+            sys.exit('%s: signal %s not traced' % (sys.argv[1], name))
+        frames, stats, bad = decode(changes[name], num)
+        decoded[name] = frames
+        print('%s: %d frames of %d pixels%s' % (name, len(frames), num,
+                                                ', %d with a wrong bit count' % bad if bad else ''))
+        for s in stats:
+            print(s.line())
+            failed |= (s.violations > 0)
+        failed |= (bad > 0)
+
+    if len(sys.argv) == 3:
+        intended = parse_log(sys.argv[2])
+        n = min(len(intended), len(decoded['PD5']), len(decoded['PD6']))
+        mismatches = 0
+        for i in range(n):
+            sent = decoded['PD5'][i] + decoded['PD6'][i]
+            if sent != intended[i]:
+                if not mismatches:
+                    print('first mismatch in frame %d:\n  intended %s\n  on wire  %s' % (
+                        i, ' '.join('%02x%02x%02x' % c for c in intended[i]),
+                        ' '.join('%02x%02x%02x' % c for c in sent)))
+                mismatches += 1
+        print('frames: %d compared, %d mismatches' % (n, mismatches))
+        failed |= (mismatches > 0) or (n == 0)
+
+    sys.exit(1 if failed else 0)
+
+
+if __name__ == '__main__':
+    main()